@@ -2,27 +2,39 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+// Instance record
 layout (location = 3) in vec3 aOffset;
 layout (location = 4) in vec3 aSize;
+layout (location = 5) in vec4 aRotation; // quaternion (x, y, z, w)
+layout (location = 6) in uint aMaterial;
 
 //out vec3 ourColor;
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+flat out uint Material;
 
 uniform mat4 model; //set in code
+uniform mat3 normalModel; // transpose(inverse(mat3(model))), set in code
 uniform mat4 view; //set in code
 uniform mat4 projection; //set in code
 
+// Rotate v by unit quaternion q
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 void main(){
-    // vec3 pos = vec3(aPos.x * aSize.x, aPos.y * aSize.y, aPos.z * aSize.z);
-    vec3 pos = aPos * aSize + aOffset;
+    // Normalized shorts lose a little length
+    vec4 q = normalize(aRotation);
+
+    vec3 pos = rotate(q, aPos * aSize) + aOffset;
 
-    // FragPos = vec3(model * vec4(pos + aOffset, 1.0));
     FragPos = vec3(model * vec4(pos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    // Inverse of scale then rotation, normalized in the fragment shader
+    Normal = normalModel * rotate(q, aNormal / aSize);
 
-    // gl_Position = projection * view * model * vec4(aPos, 1.0);
     gl_Position = projection * view * vec4(FragPos, 1.0);
     TexCoord = aTexCoord;
-}
\ No newline at end of file
+    Material = aMaterial;
+}
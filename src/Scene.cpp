@@ -1,5 +1,10 @@
 #include "Scene.hpp"
 
+#include <cmath>
+
+#include "algorithms/Octree.hpp"
+#include "algorithms/Frustum.hpp"
+
 unsigned int Scene::scrWidth = 0;
 unsigned int Scene::scrHeight = 0;
 
@@ -28,14 +33,21 @@ void Scene::framebufferSizeCallback(GLFWwindow* window, int width, int height){
     constructor
 */
 Scene::Scene() 
-    : currentId("aaaaaaa"){}
+    : currentId("aaaaaaa"), debugInstanceIds(false), octree(nullptr),
+    worldBounds(glm::vec3(-WORLD_HALF_EXTENT), glm::vec3(WORLD_HALF_EXTENT)), octreeThreads(1),
+    timestep(1.0f / SIMULATION_HZ), maxSubsteps(MAX_SUBSTEPS), accumulator(0.0f), interpolation(0.0f),
+    frustumCulling(true) {}
 Scene::Scene(int glfwVersionMajor, int glfwVersionMinor,
     const char* title, unsigned int scrWidth, unsigned int scrHeight)
     : glfwVersionMajor(glfwVersionMajor), glfwVersionMinor(glfwVersionMinor),
     title(title),
     activeCamera(-1),
     activePointLights(0), activeSpotLights(0),
-        currentId("aaaaaaa") {
+        currentId("aaaaaaa"), debugInstanceIds(false),
+        octree(nullptr),
+        worldBounds(glm::vec3(-WORLD_HALF_EXTENT), glm::vec3(WORLD_HALF_EXTENT)), octreeThreads(1),
+        timestep(1.0f / SIMULATION_HZ), maxSubsteps(MAX_SUBSTEPS), accumulator(0.0f), interpolation(0.0f),
+        frustumCulling(true) {
 
         Scene::scrWidth = scrWidth;
         Scene::scrHeight = scrHeight;
@@ -97,6 +109,11 @@ bool Scene::init(){
     glEnable(GL_DEPTH_TEST); // Doesn't show vertices not visible to camera (back of object)
     // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Disable cursor
 
+    /*
+        Octree
+    */
+    octree = new Octree::node(worldBounds);
+
     return true;
 }
 
@@ -161,6 +178,66 @@ void Scene::processInput(float deltaTime){
 void Scene::update(){
     glClearColor(bg[0], bg[1], bg[2], bg[3]);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Move instances in octree and find the visible ones
+    if (octreeThreads == 1) {
+        octree->update();
+    }
+    else {
+        octree->updateParallel(octreeThreads);
+    }
+    cullInstances();
+
+    // Moves were consumed by the octree, upload them in the next render
+    for (auto& model : models) {
+        InstanceStore& store = model.second->instances;
+        for (unsigned int i = 0, size = store.states.size(); i < size; ++i) {
+            if (States::isActive(&store.states[i], INSTANCE_MOVED)) {
+                store.markDirty(i);
+                States::deactivate(&store.states[i], INSTANCE_MOVED);
+            }
+        }
+    }
+}
+
+unsigned int Scene::simulate(float dt) {
+    accumulator += dt;
+
+    unsigned int noSteps = 0;
+    while (accumulator >= timestep && noSteps < maxSubsteps) {
+        for (auto& model : models) {
+            model.second->simulate(timestep);
+        }
+
+        accumulator -= timestep;
+        ++noSteps;
+    }
+
+    if (accumulator >= timestep) {
+        // Too far behind, drop the time instead of catching up in later frames
+        accumulator = std::fmod(accumulator, timestep);
+    }
+
+    interpolation = accumulator / timestep;
+    return noSteps;
+}
+
+void Scene::setSimulationRate(float hz) {
+    timestep = 1.0f / hz;
+    accumulator = 0.0f;
+}
+
+void Scene::cullInstances(){
+    // Reset previous frame
+    for (RigidBody* rb : visibleInstances) {
+        States::deactivate(&rb->state(), INSTANCE_VISIBLE);
+    }
+    visibleInstances.clear();
+
+    if (frustumCulling) {
+        Frustum frustum(projection * view);
+        octree->cull(frustum, visibleInstances);
+    }
 }
 
 // Update screen after frame
@@ -211,17 +288,32 @@ void Scene::renderShader(Shader shader, bool applyLighting){
     }
 }
 
-void Scene::renderInstances(std::string modelId, Shader shader, float dt) {
-    models[modelId]->render(shader, dt, this);
+void Scene::renderInstances(ModelId modelId, Shader shader) {
+    Model* model = getModel(modelId);
+    if (model) {
+        model->render(shader, this);
+    }
 }
 
 /*
     cleanup method
 */
 void Scene::cleanup(){
-    models.traverse([](Model* model) -> void {
-        model->cleanup();
-    });
+    // Octree releases its objects before the instances are deleted
+    octree->destroy();
+    delete octree;
+    octree = nullptr;
+
+    for (auto& model : models) {
+        model.second->cleanup();
+    }
+    geometryArena().cleanup();
+
+    instancesToDelete.clear();
+    removedInstances.clear();
+    instances.clear();
+    instanceIds.cleanup();
+    models.clear();
     
     glfwTerminate();
 }
@@ -255,57 +347,115 @@ void Scene::setWindowColor(float r, float g, float b, float a){
     Model/instance methods
 */
 void Scene::registerModel(Model* model){
-    models.insert(model->id, model);
+    models.insert({ model->id, model });
 }
 
-RigidBody* Scene::generateInstance(std::string modelId, glm::vec3 size, float mass, glm::vec3 pos){
-    RigidBody* rb = models[modelId]->generateInstance(size, mass, pos);
+Model* Scene::getModel(ModelId modelId){
+    auto it = models.find(modelId);
+    return it == models.end() ? nullptr : it->second;
+}
+
+RigidBody* Scene::generateInstance(ModelId modelId, glm::vec3 size, float mass, glm::vec3 pos){
+    Model* model = getModel(modelId);
+    RigidBody* rb = model ? model->generateInstance(size, mass, pos) : nullptr;
     if(rb){
         // Successfully generated
-        std::string id = generateId();
-        rb->instanceId = id;
-        instances.insert(id, rb);
+        rb->handle = instances.insert(rb);
+        if (debugInstanceIds) {
+            std::string id = generateId();
+            rb->instanceId = id;
+            instanceIds.insert(id, rb->handle);
+        }
+        octree->addToPending(rb, model);
         return rb;
     }
     return nullptr;
 }
 
 void Scene::initInstances(){
-    models.traverse([](Model* model)-> void {
-        model->initInstances();
-    });
+    for (auto& model : models) {
+        model.second->initInstances();
+    }
 }
 
 void Scene::loadModels(){
-    models.traverse([](Model* model)-> void {
-        model->init();
-    });
+    for (auto& model : models) {
+        model.second->init();
+    }
 }
 
-void Scene::removeInstance(std::string instanceId){
+RigidBody* Scene::getInstance(InstanceHandle handle){
+    RigidBody** rb = instances.get(handle);
+    return rb ? *rb : nullptr;
+}
+
+void Scene::removeInstance(InstanceHandle handle){
     /*
         Remove all locations
         - Scene::instances
         - Model::instances
+        - Scene::instanceIds (debug)
     */
 
-   std::string targetModel = instances[instanceId]->modelId;
+    RigidBody* rb = getInstance(handle);
+    if (!rb) {
+        // Stale handle
+        return;
+    }
+
+    if (!rb->instanceId.empty()) {
+        instanceIds.erase(rb->instanceId);
+    }
+
+    instances.erase(handle);
+
+    // Deletes rb
+    getModel(rb->modelId)->removeInstance(rb);
+}
 
-   models[targetModel]->removeInstance(instanceId);
+void Scene::removeInstance(std::string instanceId){
+    if (instanceIds.containsKey(instanceId)) {
+        removeInstance(instanceIds[instanceId]);
+    }
+}
 
-   instances[instanceId] = nullptr;
+void Scene::markForDeletion(InstanceHandle handle){
+    RigidBody* rb = getInstance(handle);
+    if (!rb || States::isActive(&rb->state(), INSTANCE_DEAD)) {
+        // Removed or already marked
+        return;
+    }
 
-   instances.erase(instanceId);
+    States::activate(&rb->state(), INSTANCE_DEAD);
+    instancesToDelete.push_back(rb);
 }
 
 void Scene::markForDeletion(std::string instanceId){
-    States::activate(&instances[instanceId]->state, INSTANCE_DEAD);
-    instancesToDelete.push_back(instances[instanceId]);
+    if (instanceIds.containsKey(instanceId)) {
+        markForDeletion(instanceIds[instanceId]);
+    }
 }
 
 void Scene::clearDeadInstances(){
-    for (RigidBody* rb : instancesToDelete) {
-        removeInstance(rb->instanceId);
+    if (instancesToDelete.size() > 0 || removedInstances.size() > 0) {
+        // Don't keep removed instances in visible list
+        visibleInstances.erase(std::remove_if(visibleInstances.begin(), visibleInstances.end(),
+            [](RigidBody* rb) -> bool {
+                return States::isActive(&rb->state(), INSTANCE_DEAD);
+            }), visibleInstances.end());
     }
+
+    // Instances marked before the last octree update are deleted once their objects are released
+    for (int i = removedInstances.size() - 1; i >= 0; --i) {
+        RigidBody* rb = removedInstances[i];
+        if (rb->noObjects == 0) {
+            removedInstances[i] = removedInstances.back();
+            removedInstances.pop_back();
+            removeInstance(rb->handle);
+        }
+    }
+
+    // The octree sees the dead flag in the next update
+    removedInstances.insert(removedInstances.end(), instancesToDelete.begin(), instancesToDelete.end());
     instancesToDelete.clear();
-}
\ No newline at end of file
+}
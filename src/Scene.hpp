@@ -17,17 +17,32 @@
 #include "io/Keyboard.hpp"
 #include "io/Mouse.hpp"
 
+#include "algorithms/SlotMap.hpp"
 #include "algorithms/States.hpp"
 #include "algorithms/Trie.hpp"
 
+#define SIMULATION_HZ       60.0f   // Default fixed steps per second
+#define MAX_SUBSTEPS        5       // Default cap of steps per frame (time beyond it is dropped)
+#define WORLD_HALF_EXTENT   16.0f   // Default half size of the octree root region
+
 class Model;
 
+namespace Octree {
+    class node;
+}
+
 class Scene{
 public:
-    trie::Trie<Model*> models;
-    trie::Trie<RigidBody*> instances;
+    std::map<ModelId, Model*> models;
+    slotmap::SlotMap<RigidBody*> instances;
+
+    // String ids of instances, only filled when debugInstanceIds is set
+    trie::Trie<InstanceHandle> instanceIds;
+    bool debugInstanceIds;
 
     std::vector<RigidBody*> instancesToDelete;
+    // Dead instances waiting for the octree to release their objects
+    std::vector<RigidBody*> removedInstances;
 
     // ###  Callbacks ###
     // Window resize
@@ -54,13 +69,22 @@ public:
     // Update screen before each frame
     void update();
 
+    // Advance simulation by frame time in fixed steps, returns the number of steps
+    unsigned int simulate(float dt);
+
+    // Fixed step rate
+    void setSimulationRate(float hz);
+
     // Update screen after frame
     void newFrame();
 
+    // Find instances visible from the active camera
+    void cullInstances();
+
     // Set uniform shader variables (lighting, etc.)
     void renderShader(Shader shader, bool applyLighting = true);
 
-    void renderInstances(std::string modelId, Shader shader, float dt);
+    void renderInstances(ModelId modelId, Shader shader);
 
     /*
         cleanup method
@@ -86,14 +110,23 @@ public:
     */
    void registerModel(Model* model);
 
-   RigidBody* generateInstance(std::string modelId, glm::vec3 size, float mass, glm::vec3 pos);
+   // Model of id (nullptr if it was not registered)
+   Model* getModel(ModelId modelId);
+
+   RigidBody* generateInstance(ModelId modelId, glm::vec3 size, float mass, glm::vec3 pos);
 
    void initInstances();
 
    void loadModels();
 
+   // Instance of handle (nullptr if it was removed)
+   RigidBody* getInstance(InstanceHandle handle);
+
+   // Delete instance now (only safe once the octree released it, use markForDeletion)
+   void removeInstance(InstanceHandle handle);
    void removeInstance(std::string instanceId);
 
+   void markForDeletion(InstanceHandle handle);
    void markForDeletion(std::string instanceId);
 
    void clearDeadInstances();
@@ -124,6 +157,31 @@ public:
     glm::mat4 projection;
     glm::vec3 cameraPos;
 
+    /*
+        Octree
+    */
+    Octree::node* octree;
+    // Initial root region (set before init, the root grows when objects leave it)
+    BoundingRegion worldBounds;
+    // Threads for the octree update (1 = serial, 0 = one per hardware thread)
+    unsigned int octreeThreads;
+
+    /*
+        Simulation
+    */
+    // Length of a fixed step in seconds
+    float timestep;
+    unsigned int maxSubsteps;
+    // Frame time not simulated yet
+    float accumulator;
+    // Position of the frame between the last two steps (0 to 1)
+    float interpolation;
+
+    // Only render instances in the camera frustum
+    bool frustumCulling;
+    // Instances marked INSTANCE_VISIBLE this frame
+    std::vector<RigidBody*> visibleInstances;
+
 protected:
     // Window object
     GLFWwindow* window;
@@ -1,5 +1,13 @@
 #include "Bounds.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#define RITTER_ITERATIONS 8       // Shrink and regrow passes of minimalSphere
+#define RITTER_SHRINK 0.95f       // Radius factor before each pass
+
 /*
     Constructors
 */
@@ -20,6 +28,13 @@ BoundingRegion::BoundingRegion(glm::vec3 min, glm::vec3 max)
 
 }
 
+// Initialize with typed bounds
+BoundingRegion::BoundingRegion(AABB box)
+    : BoundingRegion(box.min, box.max) {}
+
+BoundingRegion::BoundingRegion(BoundingSphere sphere)
+    : BoundingRegion(sphere.center, sphere.radius) {}
+
 /*
         Calculating values for the refion
 */
@@ -27,12 +42,14 @@ BoundingRegion::BoundingRegion(glm::vec3 min, glm::vec3 max)
 void BoundingRegion::transform(){
     if(instance){
         if (type == BoundTypes::AABB){
-            min = ogMin * instance->size + instance->pos;
-            max = ogMax * instance->size + instance->pos;
+            AABB box = AABB{ ogMin, ogMax }.transform(instance->pos(), instance->size());
+            min = box.min;
+            max = box.max;
         }
         else{
-            center = ogCenter * instance->size + instance->pos;
-            radius = ogRadius * instance->size.x;
+            BoundingSphere sphere = BoundingSphere{ ogCenter, ogRadius }.transform(instance->pos(), instance->size());
+            center = sphere.center;
+            radius = sphere.radius;
         }
     }
 }
@@ -47,121 +64,173 @@ glm::vec3 BoundingRegion::calculateDimensions(){
     return (type == BoundTypes::AABB) ? (max - min) : glm::vec3(2.0f * radius);
 }
 
+AABB BoundingRegion::box(){
+    if (type == BoundTypes::AABB) {
+        return { min, max };
+    }
+    return { center - glm::vec3(radius), center + glm::vec3(radius) };
+}
+
+BoundingSphere BoundingRegion::sphere(){
+    if (type == BoundTypes::SPHERE) {
+        return { center, radius };
+    }
+    return { (min + max) / 2.0f, glm::length(max - min) / 2.0f };
+}
+
 /*
-    Testing methods
+    Testing methods (dispatch to the typed tests)
 */
 
 // Determine if point inside
 bool BoundingRegion::containsPoint(glm::vec3 pt){
     if (type == BoundTypes::AABB){
-        // box = point must be larger than man and smaller than max
-        return (pt.x >= min.x) && (pt.x <= max.x) &&
-            (pt.x >= min.y) && (pt.x <= max.y) &&
-            (pt.x >= min.z) && (pt.x <= max.z);
+        return box().containsPoint(pt);
     } else {
-        // Sphere - distance must be less than radius
-        // x^2 + y^2 + z^2 <= r^2
-        float distSquared = 0.0f;
-        for(int i = 0; i < 3; ++i){
-            distSquared += (center[i] - pt[i]) * (center[i] - pt[i]); // cubed values
-        }
-        return distSquared <= (radius * radius);
+        return sphere().containsPoint(pt);
     }
 }
 
 // Determine if region completely inside
 bool BoundingRegion::containsRegion(BoundingRegion br){
-    if (br.type == BoundTypes::AABB) {
-        // if br is a box, just has to contain min and max
-        return containsPoint(br.min) && containsPoint(br.max);
-    }
-    else if (type == BoundTypes::SPHERE && br.type == BoundTypes::SPHERE) {
-        // if both spheres, combination of distance from centers and br.radius is less than radius
-        return glm::length(center - br.center) + br.radius < radius;
+    if (type == BoundTypes::AABB) {
+        return (br.type == BoundTypes::AABB) ? Bounds::contains(box(), br.box()) : Bounds::contains(box(), br.sphere());
     }
     else {
-        // if this is a box and br is a sphere
-        if(!containsPoint(br.center)) {
-            // center is outside of the box
-            return false;
-        }
-
-        // center inside the boc
-        /*
-            for each axis (x, y, z)
-            - if distance to each side is smaller than the radius, return false
-        */
-       for(int i = 0; i < 3; ++i){
-            if(abs(max[i] - br.center[i]) < br.radius ||
-               abs(br.center[i] - min[i]) < br.radius) {
-                return false;
-            }
-       }
-       return true;
+        return (br.type == BoundTypes::AABB) ? Bounds::contains(sphere(), br.box()) : Bounds::contains(sphere(), br.sphere());
     }
 }
 
 // Determine if region intersects (partial containment)
 bool BoundingRegion::intersectsWith(BoundingRegion br){
-    // Overlap on all axes
-    
-    if (type == BoundTypes::AABB && br.type == BoundTypes::AABB) {
-        // Both boxes
+    if (type == BoundTypes::AABB) {
+        return (br.type == BoundTypes::AABB) ? Bounds::intersects(box(), br.box()) : Bounds::intersects(box(), br.sphere());
+    }
+    else {
+        return (br.type == BoundTypes::AABB) ? Bounds::intersects(sphere(), br.box()) : Bounds::intersects(sphere(), br.sphere());
+    }
+}
+
+bool BoundingRegion::operator==(BoundingRegion br){
+    if (type != br.type){
+        return false;
+    }
+
+    if (type == BoundTypes::AABB){
+        return min == br.min && max == br.max;
+    }
+    else {
+        return center == br.center && radius == br.radius;
+    }
+}
 
-        glm::vec3 rad = calculateDimensions() / 2.0f;       // "radius" of this box
-        glm::vec3 radBr = br.calculateDimensions() / 2.0f;  // "radius" of br
+/*
+    Fitting bounds to points
+*/
 
-        glm::vec3 center = calculateCenter();               // center of this box
-        glm::vec3 centerBr = br.calculateCenter();               // center of br
+AABB Bounds::enclosingBox(const std::vector<glm::vec3>& points) {
+    if (points.empty()) {
+        return { glm::vec3(0.0f), glm::vec3(0.0f) };
+    }
 
-        glm::vec3 dist = abs(center - centerBr);
+    AABB ret = { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+    for (const glm::vec3& pt : points) {
+        ret.min = glm::min(ret.min, pt);
+        ret.max = glm::max(ret.max, pt);
+    }
+    return ret;
+}
 
-        for (int i = 0; i < 3; ++i){
-            if(dist[i] > rad[i] + radBr[i]) {
-                // No overlap on this axis
-                return false;
-            }
-        }
+// radius from center to the farthest point
+static float farthestDistance(const std::vector<glm::vec3>& points, glm::vec3 center) {
+    float maxDistSquared = 0.0f;
+    for (const glm::vec3& pt : points) {
+        glm::vec3 d = pt - center;
+        maxDistSquared = std::max(maxDistSquared, glm::dot(d, d));
+    }
+    return sqrtf(maxDistSquared);
+}
 
-        // failed to prove wrong on each axis
-        return true;
+BoundingSphere Bounds::boxCenteredSphere(const std::vector<glm::vec3>& points) {
+    glm::vec3 center = enclosingBox(points).calculateCenter();
+    return { center, farthestDistance(points, center) };
+}
+
+// grow sphere just enough to reach point
+static void growSphere(BoundingSphere& sphere, glm::vec3 pt) {
+    glm::vec3 d = pt - sphere.center;
+    float distSquared = glm::dot(d, d);
+
+    if (distSquared > sphere.radius * sphere.radius) {
+        // Move center towards point, far side of the sphere stays put
+        float dist = sqrtf(distSquared);
+        float radius = (sphere.radius + dist) / 2.0f;
+        sphere.center += d * ((radius - sphere.radius) / dist);
+        sphere.radius = radius;
     }
-    else if(type == BoundTypes::SPHERE && br.type == BoundTypes::SPHERE) {
-        // both spheres - distance between centers must be less than combined radius
+}
 
-        return glm::length(center - br.center) < (radius + br.radius);
+// Ritter - start from the most separated pair of extreme points, grow to include the rest
+static BoundingSphere ritterSphere(const std::vector<glm::vec3>& points) {
+    // Points with min and max coordinate on each axis
+    unsigned int minIdx[3] = { 0, 0, 0 };
+    unsigned int maxIdx[3] = { 0, 0, 0 };
+    for (unsigned int i = 1, n = points.size(); i < n; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            if (points[i][j] < points[minIdx[j]][j]) minIdx[j] = i;
+            if (points[i][j] > points[maxIdx[j]][j]) maxIdx[j] = i;
+        }
     }
-    else if(type == BoundTypes::SPHERE) {
-        // this is a sphere, br is a box
 
-        // determine if sphere is above top, below bottom etc
-        // find distance (squared) to the closest plane
-        float distSquared = 0.0f;
-        for (int i = 0; i < 3; ++i) {
-            // determine closest side
-            float closestPt = std::max(br.min[i], std::min(center[i], br.max[i]));
-            // add distance
-            distSquared += (closestPt - center[i]) * (closestPt - center[i]);
+    // Axis with the most separated pair
+    int axis = 0;
+    float maxDistSquared = -1.0f;
+    for (int j = 0; j < 3; ++j) {
+        glm::vec3 d = points[maxIdx[j]] - points[minIdx[j]];
+        if (glm::dot(d, d) > maxDistSquared) {
+            maxDistSquared = glm::dot(d, d);
+            axis = j;
         }
- 
-        return distSquared < (radius * radius);
     }
-    else {
-        // this is a box, br is a sphere
-        // call algorithm for br (defined in proceding else if block)
-        return br.intersectsWith(*this);
+
+    glm::vec3 a = points[minIdx[axis]];
+    glm::vec3 b = points[maxIdx[axis]];
+    BoundingSphere ret = { (a + b) / 2.0f, glm::length(b - a) / 2.0f };
+
+    for (const glm::vec3& pt : points) {
+        growSphere(ret, pt);
     }
+    return ret;
 }
 
-bool BoundingRegion::operator==(BoundingRegion br){
-    if (type != br.type){
-        return false;
+BoundingSphere Bounds::minimalSphere(const std::vector<glm::vec3>& points) {
+    if (points.empty()) {
+        return { glm::vec3(0.0f), 0.0f };
     }
 
-    if (type == BoundTypes::AABB){
-        return min == br.min && max == br.max;
-    }
-    else {
-        return center == br.center && radius == br.radius;
+    BoundingSphere ret = ritterSphere(points);
+
+    // Shrink and regrow over the points in a new order, keep the smallest
+    std::vector<glm::vec3> shuffled = points;
+    std::mt19937 rng(0); // same bounds on every import
+    BoundingSphere sphere = ret;
+
+    for (int k = 0; k < RITTER_ITERATIONS; ++k) {
+        sphere.radius *= RITTER_SHRINK;
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+        for (glm::vec3& pt : shuffled) {
+            growSphere(sphere, pt);
+        }
+
+        if (sphere.radius < ret.radius) {
+            ret = sphere;
+        }
     }
-}
\ No newline at end of file
+
+    // Exact radius for the chosen center (growing leaves rounding errors)
+    ret.radius = farthestDistance(points, ret.center);
+
+    // The box center wins for some shapes
+    BoundingSphere boxSphere = boxCenteredSphere(points);
+    return (boxSphere.radius < ret.radius) ? boxSphere : ret;
+}
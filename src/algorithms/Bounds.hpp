@@ -1,6 +1,8 @@
 #ifndef BOUNDS_HPP
 #define BOUNDS_HPP
 
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "../physics/RigidBody.hpp"
@@ -10,11 +12,153 @@ enum class BoundTypes : unsigned char {
     SPHERE = 0x01
 };
 
+/*
+    Typed bounds
+    - plain values for code that knows the kind of bound up front (eg per model)
+    - the overloads below pick the test at compile time
+    - same rules as BoundingRegion, which dispatches on type at runtime
+*/
+
+// Axis-aligned bounding box (24 bytes)
+struct AABB {
+    static constexpr BoundTypes type = BoundTypes::AABB;
+
+    glm::vec3 min;
+    glm::vec3 max;
+
+    glm::vec3 calculateCenter() const {
+        return (min + max) / 2.0f;
+    }
+
+    glm::vec3 calculateDimensions() const {
+        return max - min;
+    }
+
+    // Scale and move into world space
+    AABB transform(glm::vec3 pos, glm::vec3 size) const {
+        return { min * size + pos, max * size + pos };
+    }
+
+    bool containsPoint(glm::vec3 pt) const {
+        return pt.x >= min.x && pt.x <= max.x &&
+            pt.y >= min.y && pt.y <= max.y &&
+            pt.z >= min.z && pt.z <= max.z;
+    }
+};
+
+// Bounding sphere (16 bytes)
+struct BoundingSphere {
+    static constexpr BoundTypes type = BoundTypes::SPHERE;
+
+    glm::vec3 center;
+    float radius;
+
+    glm::vec3 calculateCenter() const {
+        return center;
+    }
+
+    glm::vec3 calculateDimensions() const {
+        return glm::vec3(2.0f * radius);
+    }
+
+    // Scale and move into world space (radius scales with size.x)
+    BoundingSphere transform(glm::vec3 pos, glm::vec3 size) const {
+        return { center * size + pos, radius * size.x };
+    }
+
+    bool containsPoint(glm::vec3 pt) const {
+        glm::vec3 d = pt - center;
+        return glm::dot(d, d) <= radius * radius;
+    }
+};
+
+namespace Bounds {
+    // squared distance from point to closest point of box
+    inline float distanceSquared(glm::vec3 pt, const AABB& box) {
+        glm::vec3 d = glm::clamp(pt, box.min, box.max) - pt;
+        return glm::dot(d, d);
+    }
+
+    /*
+        Intersection (partial containment)
+    */
+
+    // Overlap on all axes
+    inline bool intersects(const AABB& a, const AABB& b) {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+            a.min.y <= b.max.y && a.max.y >= b.min.y &&
+            a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    // Distance between centers must be less than combined radius
+    inline bool intersects(const BoundingSphere& a, const BoundingSphere& b) {
+        glm::vec3 d = a.center - b.center;
+        float radii = a.radius + b.radius;
+        return glm::dot(d, d) < radii * radii;
+    }
+
+    // Closest point of box must be inside sphere
+    inline bool intersects(const BoundingSphere& sphere, const AABB& box) {
+        return distanceSquared(sphere.center, box) < sphere.radius * sphere.radius;
+    }
+
+    inline bool intersects(const AABB& box, const BoundingSphere& sphere) {
+        return intersects(sphere, box);
+    }
+
+    /*
+        Containment (inner completely inside outer)
+    */
+
+    // Boxes only have to contain the min and max corners
+    inline bool contains(const AABB& outer, const AABB& inner) {
+        return outer.containsPoint(inner.min) && outer.containsPoint(inner.max);
+    }
+
+    inline bool contains(const BoundingSphere& outer, const AABB& inner) {
+        return outer.containsPoint(inner.min) && outer.containsPoint(inner.max);
+    }
+
+    // Distance between centers plus inner radius is less than outer radius
+    inline bool contains(const BoundingSphere& outer, const BoundingSphere& inner) {
+        return glm::length(outer.center - inner.center) + inner.radius < outer.radius;
+    }
+
+    // Center inside box and no side closer than the radius
+    inline bool contains(const AABB& outer, const BoundingSphere& inner) {
+        if (!outer.containsPoint(inner.center)) {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (outer.max[i] - inner.center[i] < inner.radius ||
+                inner.center[i] - outer.min[i] < inner.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+        Fitting bounds to points (model import)
+    */
+
+    // Smallest box around points
+    AABB enclosingBox(const std::vector<glm::vec3>& points);
+
+    // Sphere at the center of the enclosing box, reaching the farthest point
+    BoundingSphere boxCenteredSphere(const std::vector<glm::vec3>& points);
+
+    // Near-minimal sphere around points (Ritter's sphere shrunk and regrown a few times)
+    BoundingSphere minimalSphere(const std::vector<glm::vec3>& points);
+}
+
 class BoundingRegion {
 public:
     BoundTypes type;
 
-    RigidBody* instance;
+    // Instance the region moves with (nullptr for static regions)
+    RigidBody* instance = nullptr;
 
     // Sphere values
     glm::vec3 center;
@@ -43,6 +187,10 @@ public:
     // Initialize woth AABB
     BoundingRegion(glm::vec3 min, glm::vec3 max);
 
+    // Initialize with typed bounds
+    BoundingRegion(AABB box);
+    BoundingRegion(BoundingSphere sphere);
+
     /*
             Calculating values for the refion
     */
@@ -56,6 +204,12 @@ public:
     // Calculate dimensions
     glm::vec3 calculateDimensions();
 
+    // Current bounds as box (enclosing box for spheres)
+    AABB box();
+
+    // Current bounds as sphere (enclosing sphere for boxes)
+    BoundingSphere sphere();
+
     /*
         Testing methods
     */
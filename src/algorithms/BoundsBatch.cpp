@@ -0,0 +1,509 @@
+#include "BoundsBatch.hpp"
+
+#include <algorithm>
+
+#ifdef BOUNDS_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace BoundsBatch;
+
+/*
+    Level selection
+*/
+
+static SimdLevel detectLevel() {
+#ifdef BOUNDS_BATCH_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return SimdLevel::SSE;
+    }
+
+    // OS must save the AVX registers
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return SimdLevel::SSE;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? SimdLevel::AVX2 : SimdLevel::SSE;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE;
+#endif
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+static SimdLevel supportedLevel = detectLevel();
+static SimdLevel currentLevel = supportedLevel;
+
+SimdLevel BoundsBatch::getSupportedLevel() {
+    return supportedLevel;
+}
+
+SimdLevel BoundsBatch::getLevel() {
+    return currentLevel;
+}
+
+void BoundsBatch::setLevel(SimdLevel level) {
+    currentLevel = std::min(level, supportedLevel);
+}
+
+/*
+    Scalar kernels (also used for the lanes left over by the vector kernels)
+*/
+
+static unsigned int intersectBoxesScalar(glm::vec3 min, glm::vec3 max, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits, unsigned int noHits) {
+    for (unsigned int i = begin; i < end; ++i) {
+        if (min.x <= boxes.maxX[i] && max.x >= boxes.minX[i] &&
+            min.y <= boxes.maxY[i] && max.y >= boxes.minY[i] &&
+            min.z <= boxes.maxZ[i] && max.z >= boxes.minZ[i]) {
+            hits[noHits++] = i;
+        }
+    }
+    return noHits;
+}
+
+static unsigned int intersectSpheresScalar(glm::vec3 center, float radius, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits, unsigned int noHits) {
+    for (unsigned int i = begin; i < end; ++i) {
+        float dx = spheres.x[i] - center.x;
+        float dy = spheres.y[i] - center.y;
+        float dz = spheres.z[i] - center.z;
+        float radii = spheres.radius[i] + radius;
+        if (dx * dx + dy * dy + dz * dz < radii * radii) {
+            hits[noHits++] = i;
+        }
+    }
+    return noHits;
+}
+
+// squared distance from point to box on one axis
+static float axisDistanceSquared(float pt, float min, float max) {
+    float d = std::max(min, std::min(pt, max)) - pt;
+    return d * d;
+}
+
+static unsigned int intersectSphereBoxesScalar(glm::vec3 center, float radius, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits, unsigned int noHits) {
+    for (unsigned int i = begin; i < end; ++i) {
+        float distSquared = axisDistanceSquared(center.x, boxes.minX[i], boxes.maxX[i]) +
+            axisDistanceSquared(center.y, boxes.minY[i], boxes.maxY[i]) +
+            axisDistanceSquared(center.z, boxes.minZ[i], boxes.maxZ[i]);
+        if (distSquared < radius * radius) {
+            hits[noHits++] = i;
+        }
+    }
+    return noHits;
+}
+
+static unsigned int intersectBoxSpheresScalar(glm::vec3 min, glm::vec3 max, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits, unsigned int noHits) {
+    for (unsigned int i = begin; i < end; ++i) {
+        float distSquared = axisDistanceSquared(spheres.x[i], min.x, max.x) +
+            axisDistanceSquared(spheres.y[i], min.y, max.y) +
+            axisDistanceSquared(spheres.z[i], min.z, max.z);
+        if (distSquared < spheres.radius[i] * spheres.radius[i]) {
+            hits[noHits++] = i;
+        }
+    }
+    return noHits;
+}
+
+// Same as AABB::transform
+static void transformBoxesScalar(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+        out.minX[i] = og.minX[i] * transforms.sizeX[i] + transforms.posX[i];
+        out.minY[i] = og.minY[i] * transforms.sizeY[i] + transforms.posY[i];
+        out.minZ[i] = og.minZ[i] * transforms.sizeZ[i] + transforms.posZ[i];
+        out.maxX[i] = og.maxX[i] * transforms.sizeX[i] + transforms.posX[i];
+        out.maxY[i] = og.maxY[i] * transforms.sizeY[i] + transforms.posY[i];
+        out.maxZ[i] = og.maxZ[i] * transforms.sizeZ[i] + transforms.posZ[i];
+    }
+}
+
+// Same as BoundingSphere::transform, center and radius recovered from the enclosing box
+static void transformSpheresScalar(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+        float radius = (og.maxX[i] - og.minX[i]) / 2.0f * transforms.sizeX[i];
+
+        float x = (og.minX[i] + og.maxX[i]) / 2.0f * transforms.sizeX[i] + transforms.posX[i];
+        float y = (og.minY[i] + og.maxY[i]) / 2.0f * transforms.sizeY[i] + transforms.posY[i];
+        float z = (og.minZ[i] + og.maxZ[i]) / 2.0f * transforms.sizeZ[i] + transforms.posZ[i];
+
+        out.minX[i] = x - radius;
+        out.minY[i] = y - radius;
+        out.minZ[i] = z - radius;
+        out.maxX[i] = x + radius;
+        out.maxY[i] = y + radius;
+        out.maxZ[i] = z + radius;
+    }
+}
+
+#ifdef BOUNDS_BATCH_X86
+
+// append index of each set bit of mask
+static inline unsigned int compact(unsigned int mask, unsigned int base, unsigned int* hits, unsigned int noHits) {
+    while (mask) {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+#else
+        unsigned int bit = __builtin_ctz(mask);
+#endif
+        hits[noHits++] = base + bit;
+        mask &= mask - 1;
+    }
+    return noHits;
+}
+
+/*
+    SSE kernels (4 lanes)
+*/
+
+static unsigned int intersectBoxesSSE(glm::vec3 min, glm::vec3 max, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m128 minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+    __m128 maxX = _mm_set1_ps(max.x), maxY = _mm_set1_ps(max.y), maxZ = _mm_set1_ps(max.z);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 hit = _mm_and_ps(_mm_cmple_ps(minX, _mm_loadu_ps(boxes.maxX + i)),
+            _mm_cmpge_ps(maxX, _mm_loadu_ps(boxes.minX + i)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(minY, _mm_loadu_ps(boxes.maxY + i)),
+            _mm_cmpge_ps(maxY, _mm_loadu_ps(boxes.minY + i))));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(minZ, _mm_loadu_ps(boxes.maxZ + i)),
+            _mm_cmpge_ps(maxZ, _mm_loadu_ps(boxes.minZ + i))));
+        noHits = compact(_mm_movemask_ps(hit), i, hits, noHits);
+    }
+    return intersectBoxesScalar(min, max, boxes, i, end, hits, noHits);
+}
+
+static unsigned int intersectSpheresSSE(glm::vec3 center, float radius, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    __m128 r = _mm_set1_ps(radius);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(spheres.x + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(spheres.y + i), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(spheres.z + i), cz);
+        __m128 radii = _mm_add_ps(_mm_loadu_ps(spheres.radius + i), r);
+        __m128 distSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        noHits = compact(_mm_movemask_ps(_mm_cmplt_ps(distSquared, _mm_mul_ps(radii, radii))), i, hits, noHits);
+    }
+    return intersectSpheresScalar(center, radius, spheres, i, end, hits, noHits);
+}
+
+// squared distance from points to boxes on one axis
+static inline __m128 axisDistanceSquaredSSE(__m128 pt, __m128 min, __m128 max) {
+    __m128 d = _mm_sub_ps(_mm_max_ps(min, _mm_min_ps(pt, max)), pt);
+    return _mm_mul_ps(d, d);
+}
+
+static unsigned int intersectSphereBoxesSSE(glm::vec3 center, float radius, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    __m128 r2 = _mm_set1_ps(radius * radius);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 distSquared = _mm_add_ps(
+            _mm_add_ps(axisDistanceSquaredSSE(cx, _mm_loadu_ps(boxes.minX + i), _mm_loadu_ps(boxes.maxX + i)),
+                axisDistanceSquaredSSE(cy, _mm_loadu_ps(boxes.minY + i), _mm_loadu_ps(boxes.maxY + i))),
+            axisDistanceSquaredSSE(cz, _mm_loadu_ps(boxes.minZ + i), _mm_loadu_ps(boxes.maxZ + i)));
+        noHits = compact(_mm_movemask_ps(_mm_cmplt_ps(distSquared, r2)), i, hits, noHits);
+    }
+    return intersectSphereBoxesScalar(center, radius, boxes, i, end, hits, noHits);
+}
+
+static unsigned int intersectBoxSpheresSSE(glm::vec3 min, glm::vec3 max, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m128 minX = _mm_set1_ps(min.x), minY = _mm_set1_ps(min.y), minZ = _mm_set1_ps(min.z);
+    __m128 maxX = _mm_set1_ps(max.x), maxY = _mm_set1_ps(max.y), maxZ = _mm_set1_ps(max.z);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 distSquared = _mm_add_ps(
+            _mm_add_ps(axisDistanceSquaredSSE(_mm_loadu_ps(spheres.x + i), minX, maxX),
+                axisDistanceSquaredSSE(_mm_loadu_ps(spheres.y + i), minY, maxY)),
+            axisDistanceSquaredSSE(_mm_loadu_ps(spheres.z + i), minZ, maxZ));
+        __m128 r = _mm_loadu_ps(spheres.radius + i);
+        noHits = compact(_mm_movemask_ps(_mm_cmplt_ps(distSquared, _mm_mul_ps(r, r))), i, hits, noHits);
+    }
+    return intersectBoxSpheresScalar(min, max, spheres, i, end, hits, noHits);
+}
+
+// box bounds on one axis: min * size + pos, max * size + pos
+static inline void transformAxisSSE(const float* ogMin, const float* ogMax, const float* size, const float* pos,
+    float* outMin, float* outMax, unsigned int i) {
+    __m128 s = _mm_loadu_ps(size + i), p = _mm_loadu_ps(pos + i);
+    _mm_storeu_ps(outMin + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ogMin + i), s), p));
+    _mm_storeu_ps(outMax + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ogMax + i), s), p));
+}
+
+// sphere bounds on one axis: center * size + pos, minus and plus the scaled radius
+static inline void sphereAxisSSE(const float* ogMin, const float* ogMax, const float* size, const float* pos,
+    __m128 radius, float* outMin, float* outMax, unsigned int i) {
+    __m128 center = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ogMin + i), _mm_loadu_ps(ogMax + i)), _mm_set1_ps(0.5f));
+    __m128 c = _mm_add_ps(_mm_mul_ps(center, _mm_loadu_ps(size + i)), _mm_loadu_ps(pos + i));
+    _mm_storeu_ps(outMin + i, _mm_sub_ps(c, radius));
+    _mm_storeu_ps(outMax + i, _mm_add_ps(c, radius));
+}
+
+static void transformBoxesSSE(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        transformAxisSSE(og.minX, og.maxX, transforms.sizeX, transforms.posX, out.minX, out.maxX, i);
+        transformAxisSSE(og.minY, og.maxY, transforms.sizeY, transforms.posY, out.minY, out.maxY, i);
+        transformAxisSSE(og.minZ, og.maxZ, transforms.sizeZ, transforms.posZ, out.minZ, out.maxZ, i);
+    }
+    transformBoxesScalar(og, transforms, out, i, end);
+}
+
+static void transformSpheresSSE(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 radius = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(og.maxX + i), _mm_loadu_ps(og.minX + i)),
+            _mm_set1_ps(0.5f)), _mm_loadu_ps(transforms.sizeX + i));
+        sphereAxisSSE(og.minX, og.maxX, transforms.sizeX, transforms.posX, radius, out.minX, out.maxX, i);
+        sphereAxisSSE(og.minY, og.maxY, transforms.sizeY, transforms.posY, radius, out.minY, out.maxY, i);
+        sphereAxisSSE(og.minZ, og.maxZ, transforms.sizeZ, transforms.posZ, radius, out.minZ, out.maxZ, i);
+    }
+    transformSpheresScalar(og, transforms, out, i, end);
+}
+
+/*
+    AVX2 kernels (8 lanes)
+*/
+
+AVX2_TARGET static unsigned int intersectBoxesAVX2(glm::vec3 min, glm::vec3 max, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m256 minX = _mm256_set1_ps(min.x), minY = _mm256_set1_ps(min.y), minZ = _mm256_set1_ps(min.z);
+    __m256 maxX = _mm256_set1_ps(max.x), maxY = _mm256_set1_ps(max.y), maxZ = _mm256_set1_ps(max.z);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(minX, _mm256_loadu_ps(boxes.maxX + i), _CMP_LE_OQ),
+            _mm256_cmp_ps(maxX, _mm256_loadu_ps(boxes.minX + i), _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(minY, _mm256_loadu_ps(boxes.maxY + i), _CMP_LE_OQ),
+            _mm256_cmp_ps(maxY, _mm256_loadu_ps(boxes.minY + i), _CMP_GE_OQ)));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(minZ, _mm256_loadu_ps(boxes.maxZ + i), _CMP_LE_OQ),
+            _mm256_cmp_ps(maxZ, _mm256_loadu_ps(boxes.minZ + i), _CMP_GE_OQ)));
+        noHits = compact(_mm256_movemask_ps(hit), i, hits, noHits);
+    }
+    return intersectBoxesScalar(min, max, boxes, i, end, hits, noHits);
+}
+
+AVX2_TARGET static unsigned int intersectSpheresAVX2(glm::vec3 center, float radius, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+    __m256 r = _mm256_set1_ps(radius);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(spheres.x + i), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(spheres.y + i), cy);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(spheres.z + i), cz);
+        __m256 radii = _mm256_add_ps(_mm256_loadu_ps(spheres.radius + i), r);
+        __m256 distSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+            _mm256_mul_ps(dz, dz));
+        noHits = compact(_mm256_movemask_ps(_mm256_cmp_ps(distSquared, _mm256_mul_ps(radii, radii), _CMP_LT_OQ)),
+            i, hits, noHits);
+    }
+    return intersectSpheresScalar(center, radius, spheres, i, end, hits, noHits);
+}
+
+// squared distance from points to boxes on one axis
+AVX2_TARGET static inline __m256 axisDistanceSquaredAVX2(__m256 pt, __m256 min, __m256 max) {
+    __m256 d = _mm256_sub_ps(_mm256_max_ps(min, _mm256_min_ps(pt, max)), pt);
+    return _mm256_mul_ps(d, d);
+}
+
+AVX2_TARGET static unsigned int intersectSphereBoxesAVX2(glm::vec3 center, float radius, BoxArrays& boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+    __m256 r2 = _mm256_set1_ps(radius * radius);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 distSquared = _mm256_add_ps(
+            _mm256_add_ps(axisDistanceSquaredAVX2(cx, _mm256_loadu_ps(boxes.minX + i), _mm256_loadu_ps(boxes.maxX + i)),
+                axisDistanceSquaredAVX2(cy, _mm256_loadu_ps(boxes.minY + i), _mm256_loadu_ps(boxes.maxY + i))),
+            axisDistanceSquaredAVX2(cz, _mm256_loadu_ps(boxes.minZ + i), _mm256_loadu_ps(boxes.maxZ + i)));
+        noHits = compact(_mm256_movemask_ps(_mm256_cmp_ps(distSquared, r2, _CMP_LT_OQ)), i, hits, noHits);
+    }
+    return intersectSphereBoxesScalar(center, radius, boxes, i, end, hits, noHits);
+}
+
+AVX2_TARGET static unsigned int intersectBoxSpheresAVX2(glm::vec3 min, glm::vec3 max, SphereArrays& spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+    __m256 minX = _mm256_set1_ps(min.x), minY = _mm256_set1_ps(min.y), minZ = _mm256_set1_ps(min.z);
+    __m256 maxX = _mm256_set1_ps(max.x), maxY = _mm256_set1_ps(max.y), maxZ = _mm256_set1_ps(max.z);
+
+    unsigned int noHits = 0;
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 distSquared = _mm256_add_ps(
+            _mm256_add_ps(axisDistanceSquaredAVX2(_mm256_loadu_ps(spheres.x + i), minX, maxX),
+                axisDistanceSquaredAVX2(_mm256_loadu_ps(spheres.y + i), minY, maxY)),
+            axisDistanceSquaredAVX2(_mm256_loadu_ps(spheres.z + i), minZ, maxZ));
+        __m256 r = _mm256_loadu_ps(spheres.radius + i);
+        noHits = compact(_mm256_movemask_ps(_mm256_cmp_ps(distSquared, _mm256_mul_ps(r, r), _CMP_LT_OQ)),
+            i, hits, noHits);
+    }
+    return intersectBoxSpheresScalar(min, max, spheres, i, end, hits, noHits);
+}
+
+AVX2_TARGET static inline void transformAxisAVX2(const float* ogMin, const float* ogMax, const float* size,
+    const float* pos, float* outMin, float* outMax, unsigned int i) {
+    __m256 s = _mm256_loadu_ps(size + i), p = _mm256_loadu_ps(pos + i);
+    _mm256_storeu_ps(outMin + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(ogMin + i), s), p));
+    _mm256_storeu_ps(outMax + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(ogMax + i), s), p));
+}
+
+AVX2_TARGET static inline void sphereAxisAVX2(const float* ogMin, const float* ogMax, const float* size,
+    const float* pos, __m256 radius, float* outMin, float* outMax, unsigned int i) {
+    __m256 center = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(ogMin + i), _mm256_loadu_ps(ogMax + i)),
+        _mm256_set1_ps(0.5f));
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(center, _mm256_loadu_ps(size + i)), _mm256_loadu_ps(pos + i));
+    _mm256_storeu_ps(outMin + i, _mm256_sub_ps(c, radius));
+    _mm256_storeu_ps(outMax + i, _mm256_add_ps(c, radius));
+}
+
+AVX2_TARGET static void transformBoxesAVX2(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        transformAxisAVX2(og.minX, og.maxX, transforms.sizeX, transforms.posX, out.minX, out.maxX, i);
+        transformAxisAVX2(og.minY, og.maxY, transforms.sizeY, transforms.posY, out.minY, out.maxY, i);
+        transformAxisAVX2(og.minZ, og.maxZ, transforms.sizeZ, transforms.posZ, out.minZ, out.maxZ, i);
+    }
+    transformBoxesScalar(og, transforms, out, i, end);
+}
+
+AVX2_TARGET static void transformSpheresAVX2(BoxArrays& og, TransformArrays& transforms, OutBoxArrays& out,
+    unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 radius = _mm256_mul_ps(_mm256_mul_ps(
+            _mm256_sub_ps(_mm256_loadu_ps(og.maxX + i), _mm256_loadu_ps(og.minX + i)), _mm256_set1_ps(0.5f)),
+            _mm256_loadu_ps(transforms.sizeX + i));
+        sphereAxisAVX2(og.minX, og.maxX, transforms.sizeX, transforms.posX, radius, out.minX, out.maxX, i);
+        sphereAxisAVX2(og.minY, og.maxY, transforms.sizeY, transforms.posY, radius, out.minY, out.maxY, i);
+        sphereAxisAVX2(og.minZ, og.maxZ, transforms.sizeZ, transforms.posZ, radius, out.minZ, out.maxZ, i);
+    }
+    transformSpheresScalar(og, transforms, out, i, end);
+}
+
+#endif
+
+/*
+    Dispatch
+*/
+
+unsigned int BoundsBatch::intersectBoxes(glm::vec3 min, glm::vec3 max, BoxArrays boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        return intersectBoxesAVX2(min, max, boxes, begin, end, hits);
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        return intersectBoxesSSE(min, max, boxes, begin, end, hits);
+    }
+#endif
+    return intersectBoxesScalar(min, max, boxes, begin, end, hits, 0);
+}
+
+unsigned int BoundsBatch::intersectSpheres(glm::vec3 center, float radius, SphereArrays spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        return intersectSpheresAVX2(center, radius, spheres, begin, end, hits);
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        return intersectSpheresSSE(center, radius, spheres, begin, end, hits);
+    }
+#endif
+    return intersectSpheresScalar(center, radius, spheres, begin, end, hits, 0);
+}
+
+unsigned int BoundsBatch::intersectSphereBoxes(glm::vec3 center, float radius, BoxArrays boxes,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        return intersectSphereBoxesAVX2(center, radius, boxes, begin, end, hits);
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        return intersectSphereBoxesSSE(center, radius, boxes, begin, end, hits);
+    }
+#endif
+    return intersectSphereBoxesScalar(center, radius, boxes, begin, end, hits, 0);
+}
+
+unsigned int BoundsBatch::intersectBoxSpheres(glm::vec3 min, glm::vec3 max, SphereArrays spheres,
+    unsigned int begin, unsigned int end, unsigned int* hits) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        return intersectBoxSpheresAVX2(min, max, spheres, begin, end, hits);
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        return intersectBoxSpheresSSE(min, max, spheres, begin, end, hits);
+    }
+#endif
+    return intersectBoxSpheresScalar(min, max, spheres, begin, end, hits, 0);
+}
+
+void BoundsBatch::transformBoxes(BoxArrays og, TransformArrays transforms, OutBoxArrays out,
+    unsigned int begin, unsigned int end) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        transformBoxesAVX2(og, transforms, out, begin, end);
+        return;
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        transformBoxesSSE(og, transforms, out, begin, end);
+        return;
+    }
+#endif
+    transformBoxesScalar(og, transforms, out, begin, end);
+}
+
+void BoundsBatch::transformSpheres(BoxArrays og, TransformArrays transforms, OutBoxArrays out,
+    unsigned int begin, unsigned int end) {
+#ifdef BOUNDS_BATCH_X86
+    if (currentLevel == SimdLevel::AVX2) {
+        transformSpheresAVX2(og, transforms, out, begin, end);
+        return;
+    }
+    if (currentLevel == SimdLevel::SSE) {
+        transformSpheresSSE(og, transforms, out, begin, end);
+        return;
+    }
+#endif
+    transformSpheresScalar(og, transforms, out, begin, end);
+}
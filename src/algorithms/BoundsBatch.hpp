@@ -0,0 +1,153 @@
+#ifndef BOUNDS_BATCH_HPP
+#define BOUNDS_BATCH_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    Batched intersection kernels
+    - test one region against many regions stored as structure of arrays
+    - hits are written as a compacted list of indices, the number of hits is returned
+    - transform kernels apply instance position and size to many boxes at once
+    - AVX2 (8 lanes, picked at runtime) or SSE (4 lanes) on x86-64
+    - scalar elsewhere or when BOUNDS_BATCH_SCALAR is defined
+    - same rules as BoundingRegion::intersectsWith (boxes touching count as hits)
+*/
+
+#if !defined(BOUNDS_BATCH_SCALAR) && (defined(__x86_64__) || defined(_M_X64))
+#define BOUNDS_BATCH_X86
+#endif
+
+namespace BoundsBatch {
+    enum class SimdLevel : unsigned char {
+        SCALAR = 0,
+        SSE = 1,
+        AVX2 = 2
+    };
+
+    // Boxes as separate arrays per component
+    struct BoxArrays {
+        const float* minX;
+        const float* minY;
+        const float* minZ;
+        const float* maxX;
+        const float* maxY;
+        const float* maxZ;
+    };
+
+    // Spheres as separate arrays per component
+    struct SphereArrays {
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* radius;
+    };
+
+    // Writable boxes as separate arrays per component (output of the transform kernels)
+    struct OutBoxArrays {
+        float* minX;
+        float* minY;
+        float* minZ;
+        float* maxX;
+        float* maxY;
+        float* maxZ;
+    };
+
+    // Instance positions and sizes as separate arrays per component
+    struct TransformArrays {
+        const float* posX;
+        const float* posY;
+        const float* posZ;
+        const float* sizeX;
+        const float* sizeY;
+        const float* sizeZ;
+    };
+
+    // Growable box arrays
+    struct BoxList {
+        std::vector<float> minX;
+        std::vector<float> minY;
+        std::vector<float> minZ;
+        std::vector<float> maxX;
+        std::vector<float> maxY;
+        std::vector<float> maxZ;
+
+        void push_back(glm::vec3 min, glm::vec3 max) {
+            minX.push_back(min.x);
+            minY.push_back(min.y);
+            minZ.push_back(min.z);
+            maxX.push_back(max.x);
+            maxY.push_back(max.y);
+            maxZ.push_back(max.z);
+        }
+
+        void resize(unsigned int size) {
+            minX.resize(size);
+            minY.resize(size);
+            minZ.resize(size);
+            maxX.resize(size);
+            maxY.resize(size);
+            maxZ.resize(size);
+        }
+
+        void clear() {
+            resize(0);
+        }
+
+        unsigned int size() {
+            return minX.size();
+        }
+
+        BoxArrays arrays() {
+            return { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+        }
+
+        OutBoxArrays outArrays() {
+            return { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+        }
+    };
+
+    // Best level supported by the CPU
+    SimdLevel getSupportedLevel();
+
+    // Level used by the kernels (defaults to the supported level)
+    SimdLevel getLevel();
+
+    // Force level (clamped to the supported level), for testing and benchmarks
+    void setLevel(SimdLevel level);
+
+    /*
+        Kernels (test indices [begin, end), write hit indices to hits)
+    */
+
+    // box against boxes
+    unsigned int intersectBoxes(glm::vec3 min, glm::vec3 max, BoxArrays boxes,
+        unsigned int begin, unsigned int end, unsigned int* hits);
+
+    // sphere against spheres
+    unsigned int intersectSpheres(glm::vec3 center, float radius, SphereArrays spheres,
+        unsigned int begin, unsigned int end, unsigned int* hits);
+
+    // sphere against boxes
+    unsigned int intersectSphereBoxes(glm::vec3 center, float radius, BoxArrays boxes,
+        unsigned int begin, unsigned int end, unsigned int* hits);
+
+    // box against spheres
+    unsigned int intersectBoxSpheres(glm::vec3 min, glm::vec3 max, SphereArrays spheres,
+        unsigned int begin, unsigned int end, unsigned int* hits);
+
+    /*
+        Transform kernels (indices [begin, end) of og and transforms, written to out at the same index)
+    */
+
+    // boxes scaled by size and moved by pos (same as AABB::transform)
+    void transformBoxes(BoxArrays og, TransformArrays transforms, OutBoxArrays out,
+        unsigned int begin, unsigned int end);
+
+    // spheres stored as their enclosing box, radius scales with size.x (same as BoundingSphere::transform)
+    void transformSpheres(BoxArrays og, TransformArrays transforms, OutBoxArrays out,
+        unsigned int begin, unsigned int end);
+}
+
+#endif //BOUNDS_BATCH_HPP
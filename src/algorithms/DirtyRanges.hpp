@@ -0,0 +1,149 @@
+#ifndef DIRTY_RANGES_HPP
+#define DIRTY_RANGES_HPP
+
+#include <vector>
+
+#define DIRTY_MAX_SPANS     8       // Default number of spans kept before merging the closest
+#define DIRTY_MERGE_GAP     16      // Default gap (elements) bridged right away, one upload beats two
+
+/*
+    Dirty element ranges of an array
+    - sorted, disjoint spans [begin, end)
+    - marks close to a span (within mergeGap) extend it
+    - past maxSpans the two spans with the smallest gap are merged, so uploads stay few
+*/
+class DirtyRanges {
+public:
+    struct Span {
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    unsigned int maxSpans;
+    unsigned int mergeGap;
+
+    DirtyRanges(unsigned int maxSpans = DIRTY_MAX_SPANS, unsigned int mergeGap = DIRTY_MERGE_GAP)
+        : maxSpans(maxSpans > 0 ? maxSpans : 1), mergeGap(mergeGap) {}
+
+    /*
+        modifiers
+    */
+
+    // mark element
+    void mark(unsigned int idx) {
+        mark(idx, idx + 1);
+    }
+
+    // mark elements [begin, end)
+    void mark(unsigned int begin, unsigned int end) {
+        if (begin >= end) {
+            return;
+        }
+
+        // Marks usually come in increasing order, try the last span first
+        if (spans.size() > 0 && begin >= spans.back().begin) {
+            Span& last = spans.back();
+            if (begin <= last.end + mergeGap) {
+                if (end > last.end) {
+                    last.end = end;
+                }
+                return;
+            }
+
+            spans.push_back({ begin, end });
+        }
+        else {
+            insert(begin, end);
+        }
+
+        if (spans.size() > maxSpans) {
+            mergeClosest();
+        }
+    }
+
+    // drop elements at and past size (array shrank)
+    void clamp(unsigned int size) {
+        while (spans.size() > 0 && spans.back().begin >= size) {
+            spans.pop_back();
+        }
+        if (spans.size() > 0 && spans.back().end > size) {
+            spans.back().end = size;
+        }
+    }
+
+    void clear() {
+        spans.clear();
+    }
+
+    /*
+        accessors
+    */
+
+    bool empty() {
+        return spans.empty();
+    }
+
+    std::vector<Span>& getSpans() {
+        return spans;
+    }
+
+    // total marked elements (including bridged gaps)
+    unsigned int noElements() {
+        unsigned int ret = 0;
+        for (Span& span : spans) {
+            ret += span.end - span.begin;
+        }
+        return ret;
+    }
+
+private:
+    std::vector<Span> spans;
+
+    // insert span in order, merging the spans it touches
+    void insert(unsigned int begin, unsigned int end) {
+        // First span that may touch [begin, end)
+        unsigned int i = 0;
+        while (i < spans.size() && spans[i].end + mergeGap < begin) {
+            ++i;
+        }
+
+        // Swallow every span starting before end (+ gap)
+        unsigned int j = i;
+        while (j < spans.size() && spans[j].begin <= end + mergeGap) {
+            if (spans[j].begin < begin) {
+                begin = spans[j].begin;
+            }
+            if (spans[j].end > end) {
+                end = spans[j].end;
+            }
+            ++j;
+        }
+
+        if (i == j) {
+            spans.insert(spans.begin() + i, { begin, end });
+        }
+        else {
+            spans[i] = { begin, end };
+            spans.erase(spans.begin() + i + 1, spans.begin() + j);
+        }
+    }
+
+    // merge the neighbours with the smallest gap
+    void mergeClosest() {
+        unsigned int best = 0;
+        unsigned int bestGap = spans[1].begin - spans[0].end;
+
+        for (unsigned int i = 1, size = spans.size() - 1; i < size; ++i) {
+            unsigned int gap = spans[i + 1].begin - spans[i].end;
+            if (gap < bestGap) {
+                best = i;
+                bestGap = gap;
+            }
+        }
+
+        spans[best].end = spans[best + 1].end;
+        spans.erase(spans.begin() + best + 1);
+    }
+};
+
+#endif //DIRTY_RANGES_HPP
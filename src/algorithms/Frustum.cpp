@@ -0,0 +1,95 @@
+#include "Frustum.hpp"
+
+/*
+    Constructors
+*/
+
+Frustum::Frustum() {
+    // Accept everything
+    for (int i = 0; i < NO_FRUSTUM_PLANES; ++i) {
+        planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+Frustum::Frustum(glm::mat4 viewProjection) {
+    // Rows of the matrix (glm is column major)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    // Gribb-Hartmann extraction
+    planes[0] = rows[3] + rows[0]; // left
+    planes[1] = rows[3] - rows[0]; // right
+    planes[2] = rows[3] + rows[1]; // bottom
+    planes[3] = rows[3] - rows[1]; // top
+    planes[4] = rows[3] + rows[2]; // near
+    planes[5] = rows[3] - rows[2]; // far
+
+    // Normalize so distances are in world units
+    for (int i = 0; i < NO_FRUSTUM_PLANES; ++i) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+/*
+    Testing methods
+*/
+
+FrustumTest Frustum::classify(BoundingRegion& br) {
+    return (br.type == BoundTypes::AABB) ? classify(br.box()) : classify(br.sphere());
+}
+
+FrustumTest Frustum::classify(const AABB& box) {
+    FrustumTest ret = FrustumTest::INSIDE;
+
+    for (int i = 0; i < NO_FRUSTUM_PLANES; ++i) {
+        glm::vec3 normal(planes[i]);
+
+        // Corner furthest along the normal (p) and furthest against it (n)
+        glm::vec3 p = glm::mix(box.min, box.max, glm::step(glm::vec3(0.0f), normal));
+        glm::vec3 n = glm::mix(box.max, box.min, glm::step(glm::vec3(0.0f), normal));
+
+        if (glm::dot(normal, p) + planes[i].w < 0.0f) {
+            // Whole box behind plane
+            return FrustumTest::OUTSIDE;
+        }
+        if (glm::dot(normal, n) + planes[i].w < 0.0f) {
+            // Box straddles plane
+            ret = FrustumTest::INTERSECT;
+        }
+    }
+
+    return ret;
+}
+
+FrustumTest Frustum::classify(const BoundingSphere& sphere) {
+    FrustumTest ret = FrustumTest::INSIDE;
+
+    for (int i = 0; i < NO_FRUSTUM_PLANES; ++i) {
+        float dist = glm::dot(glm::vec3(planes[i]), sphere.center) + planes[i].w;
+
+        if (dist < -sphere.radius) {
+            // Whole sphere behind plane
+            return FrustumTest::OUTSIDE;
+        }
+        if (dist < sphere.radius) {
+            // Sphere straddles plane
+            ret = FrustumTest::INTERSECT;
+        }
+    }
+
+    return ret;
+}
+
+bool Frustum::intersectsWith(BoundingRegion& br) {
+    return classify(br) != FrustumTest::OUTSIDE;
+}
+
+bool Frustum::intersectsWith(const AABB& box) {
+    return classify(box) != FrustumTest::OUTSIDE;
+}
+
+bool Frustum::intersectsWith(const BoundingSphere& sphere) {
+    return classify(sphere) != FrustumTest::OUTSIDE;
+}
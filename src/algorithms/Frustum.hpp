@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+#define NO_FRUSTUM_PLANES 6
+
+enum class FrustumTest : unsigned char {
+    OUTSIDE = 0x00,     // Completely outside
+    INTERSECT = 0x01,   // Partially inside
+    INSIDE = 0x02       // Completely inside
+};
+
+class Frustum {
+public:
+    // Planes (xyz = normal pointing inside, w = distance)
+    // left, right, bottom, top, near, far
+    glm::vec4 planes[NO_FRUSTUM_PLANES];
+
+    /*
+        Constructors
+    */
+
+    Frustum();
+
+    // Extract planes from view-projection matrix
+    Frustum(glm::mat4 viewProjection);
+
+    /*
+        Testing methods
+    */
+
+    // Classify region against frustum
+    FrustumTest classify(BoundingRegion& br);
+    FrustumTest classify(const AABB& box);
+    FrustumTest classify(const BoundingSphere& sphere);
+
+    // Determine if region is at least partially visible
+    bool intersectsWith(BoundingRegion& br);
+    bool intersectsWith(const AABB& box);
+    bool intersectsWith(const BoundingSphere& sphere);
+};
+
+#endif //FRUSTUM_HPP
@@ -0,0 +1,38 @@
+#include "InternedId.hpp"
+
+#include <stdexcept>
+
+interned::Id interned::Registry::intern(const std::string& name) {
+    Id id = hash(name);
+
+    auto it = names.find(id);
+    if (it == names.end()) {
+        names[id] = name;
+    }
+    else if (it->second != name) {
+        // Different names with the same id, one of them must be renamed
+        throw std::runtime_error("id collision between \"" + it->second + "\" and \"" + name + "\"");
+    }
+
+    return id;
+}
+
+bool interned::Registry::contains(Id id) {
+    return names.find(id) != names.end();
+}
+
+const std::string& interned::Registry::getName(Id id) {
+    static const std::string empty;
+
+    auto it = names.find(id);
+    return it == names.end() ? empty : it->second;
+}
+
+unsigned int interned::Registry::size() {
+    return names.size();
+}
+
+interned::Registry& interned::registry() {
+    static Registry ret;
+    return ret;
+}
@@ -0,0 +1,66 @@
+#ifndef INTERNED_ID_HPP
+#define INTERNED_ID_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+/*
+    Interned identifiers
+    - names are hashed to 64 bit integers (FNV-1a)
+    - hash() is constexpr, so ids of literals are computed at compile time
+    - names read at runtime go through a Registry, which keeps the name of each id
+      and throws when two different names hash to the same id
+*/
+
+#define FNV_OFFSET_BASIS    0xcbf29ce484222325ull
+#define FNV_PRIME           0x100000001b3ull
+
+namespace interned {
+    typedef unsigned long long Id;
+
+    // FNV-1a hash of length characters
+    constexpr Id hash(const char* str, size_t length) {
+        Id ret = FNV_OFFSET_BASIS;
+        for (size_t i = 0; i < length; ++i) {
+            ret ^= (unsigned char)str[i];
+            ret *= FNV_PRIME;
+        }
+        return ret;
+    }
+
+    // FNV-1a hash of null terminated string
+    constexpr Id hash(const char* str) {
+        size_t length = 0;
+        while (str[length]) {
+            ++length;
+        }
+        return hash(str, length);
+    }
+
+    inline Id hash(const std::string& str) {
+        return hash(str.c_str(), str.length());
+    }
+
+    class Registry {
+    public:
+        // hash name and remember it, throws std::runtime_error on collision
+        Id intern(const std::string& name);
+
+        // determine if id was interned
+        bool contains(Id id);
+
+        // name of id (empty if it was not interned)
+        const std::string& getName(Id id);
+
+        unsigned int size();
+
+    private:
+        std::unordered_map<Id, std::string> names;
+    };
+
+    // Registry shared by the engine
+    Registry& registry();
+}
+
+#endif //INTERNED_ID_HPP
@@ -0,0 +1,437 @@
+#include "ObjectTable.hpp"
+
+#include <algorithm>
+
+#include "Parallel.hpp"
+#include "States.hpp"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+#define TRANSFORM_BATCH_SIZE        512 // Moved objects staged before the kernel runs
+#define TRANSFORM_PREFETCH_DISTANCE 16  // Objects the gather and scatter look ahead
+
+// Hint that addr will be read soon
+static inline void prefetchRead(const void* addr) {
+#if defined(__GNUC__)
+    __builtin_prefetch(addr, 0);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    _mm_prefetch((const char*)addr, _MM_HINT_T0);
+#endif
+}
+
+// Hint that addr will be written soon
+static inline void prefetchWrite(const void* addr) {
+#if defined(__GNUC__)
+    __builtin_prefetch(addr, 1);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    _mm_prefetch((const char*)addr, _MM_HINT_T0);
+#endif
+}
+
+unsigned int Octree::ObjectTable::add(BoundingRegion& br) {
+    unsigned int handle;
+
+    if (freeList.size() > 0) {
+        // Recycle released handle
+        handle = freeList.back();
+        freeList.pop_back();
+    }
+    else {
+        handle = types.size();
+        minX.push_back(0.0f);
+        minY.push_back(0.0f);
+        minZ.push_back(0.0f);
+        maxX.push_back(0.0f);
+        maxY.push_back(0.0f);
+        maxZ.push_back(0.0f);
+        types.push_back(br.type);
+        instances.push_back(nullptr);
+        og.push_back({ glm::vec3(0.0f), glm::vec3(0.0f) });
+        storePos.push_back(0);
+    }
+
+    types[handle] = br.type;
+    instances[handle] = br.instance;
+    if (br.instance) {
+        ++br.instance->noObjects;
+    }
+
+    if (br.type == BoundTypes::AABB) {
+        og[handle] = { br.ogMin, br.ogMax };
+
+        setBox(handle, br.box());
+    }
+    else {
+        og[handle] = { br.ogCenter - glm::vec3(br.ogRadius), br.ogCenter + glm::vec3(br.ogRadius) };
+
+        setSphere(handle, br.sphere());
+    }
+
+    // Group by store, so transformMoved reads the store arrays in order
+    unsigned int group = findStore(br.instance, br.type);
+    if (group != NULL_OBJECT) {
+        StoreObjects& objects = stores[group];
+        if (objects.instanceIdx.size() > 0 && br.instance->instanceIdx < objects.instanceIdx.back()) {
+            objects.sorted = false;
+        }
+
+        storePos[handle] = objects.handles.size();
+        objects.handles.push_back(handle);
+        objects.instanceIdx.push_back(br.instance->instanceIdx);
+    }
+
+    return handle;
+}
+
+void Octree::ObjectTable::release(unsigned int handle) {
+    std::lock_guard<std::mutex> lock(releaseMutex);
+
+    RigidBody* instance = instances[handle];
+    if (instance) {
+        --instance->noObjects;
+
+        // Move the last entry of the group into the hole
+        StoreObjects& objects = stores[findStore(instance, types[handle])];
+        unsigned int pos = storePos[handle];
+        unsigned int last = objects.handles.size() - 1;
+        if (pos != last) {
+            objects.handles[pos] = objects.handles[last];
+            objects.instanceIdx[pos] = objects.instanceIdx[last];
+            storePos[objects.handles[pos]] = pos;
+            objects.sorted = false;
+        }
+
+        objects.handles.pop_back();
+        objects.instanceIdx.pop_back();
+    }
+    instances[handle] = nullptr;
+    freeList.push_back(handle);
+}
+
+void Octree::ObjectTable::clear() {
+    minX.clear();
+    minY.clear();
+    minZ.clear();
+    maxX.clear();
+    maxY.clear();
+    maxZ.clear();
+    types.clear();
+    instances.clear();
+    og.clear();
+    freeList.clear();
+    stores.clear();
+    storePos.clear();
+}
+
+void Octree::ObjectTable::transform(unsigned int handle) {
+    RigidBody* instance = instances[handle];
+    if (!instance) {
+        return;
+    }
+
+    AABB& box = og[handle];
+
+    if (types[handle] == BoundTypes::AABB) {
+        setBox(handle, box.transform(instance->pos(), instance->size()));
+    }
+    else {
+        BoundingSphere ogSphere = { box.calculateCenter(), (box.max.x - box.min.x) / 2.0f };
+        setSphere(handle, ogSphere.transform(instance->pos(), instance->size()));
+    }
+}
+
+unsigned int Octree::ObjectTable::transformMoved() {
+    unsigned int ret = 0;
+
+    // Gather - the only pass reading the instances, each store front to back
+    for (StoreObjects& objects : stores) {
+        if (objects.handles.empty()) {
+            continue;
+        }
+
+        if (objects.noRemovals != objects.store->noRemovals) {
+            refreshStore(objects);
+        }
+        if (!objects.sorted) {
+            sortStore(objects);
+        }
+
+        ret += gatherMoved(objects, (objects.type == BoundTypes::AABB) ? boxBatch : sphereBatch);
+    }
+
+    flush(boxBatch);
+    flush(sphereBatch);
+
+    return ret;
+}
+
+unsigned int Octree::ObjectTable::findStore(RigidBody* instance, BoundTypes type) {
+    if (!instance) {
+        return NULL_OBJECT;
+    }
+
+    for (unsigned int i = 0, length = stores.size(); i < length; ++i) {
+        if (stores[i].store == instance->store && stores[i].type == type) {
+            return i;
+        }
+    }
+
+    stores.emplace_back(instance->store, type);
+    return stores.size() - 1;
+}
+
+void Octree::ObjectTable::sortStore(StoreObjects& objects) {
+    unsigned int size = objects.handles.size();
+
+    // Sort entry positions by instance index
+    std::vector<unsigned int> keys = objects.instanceIdx;
+    std::vector<unsigned int> order(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        order[i] = i;
+    }
+
+    unsigned int maxKey = *std::max_element(keys.begin(), keys.end());
+    unsigned int keyBits = 8;
+    while (keyBits < 32 && (maxKey >> keyBits) > 0) {
+        keyBits += 8;
+    }
+    Parallel::radixSort(keys, order, keyBits);
+
+    // Permute handles
+    std::vector<unsigned int> handles(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        handles[i] = objects.handles[order[i]];
+        storePos[handles[i]] = i;
+    }
+
+    objects.handles.swap(handles);
+    objects.instanceIdx.swap(keys);
+    objects.sorted = true;
+}
+
+void Octree::ObjectTable::refreshStore(StoreObjects& objects) {
+    for (unsigned int i = 0, length = objects.handles.size(); i < length; ++i) {
+        unsigned int idx = instances[objects.handles[i]]->instanceIdx;
+        if (idx != objects.instanceIdx[i]) {
+            objects.instanceIdx[i] = idx;
+            objects.sorted = false;
+        }
+    }
+    objects.noRemovals = objects.store->noRemovals;
+}
+
+unsigned int Octree::ObjectTable::gatherMoved(StoreObjects& objects, TransformBatch& batch) {
+    InstanceStore& store = *objects.store;
+    unsigned int ret = 0;
+    const unsigned int* handles = objects.handles.data();
+    const unsigned int* instanceIdx = objects.instanceIdx.data();
+
+    for (unsigned int i = 0, length = objects.handles.size(); i < length; ++i) {
+        // Handles are random in instance order, fetch the untransformed bounds ahead
+        if (i + TRANSFORM_PREFETCH_DISTANCE < length) {
+            unsigned int next = handles[i + TRANSFORM_PREFETCH_DISTANCE];
+            prefetchRead(&og[next]);
+        }
+
+        unsigned int idx = instanceIdx[i];
+        if (!States::isActive(&store.states[idx], INSTANCE_MOVED)) {
+            continue;
+        }
+
+        unsigned int handle = handles[i];
+        batch.add(handle, store.pos[idx], store.size[idx], og[handle].min, og[handle].max);
+        ++ret;
+        if (batch.full()) {
+            flush(batch);
+        }
+    }
+
+    return ret;
+}
+
+void Octree::ObjectTable::flush(TransformBatch& batch) {
+    if (batch.count == 0) {
+        return;
+    }
+
+    // Transform staged arrays (SIMD)
+    if (&batch == &boxBatch) {
+        BoundsBatch::transformBoxes(batch.og.arrays(), batch.transforms(), batch.out.outArrays(), 0, batch.count);
+    }
+    else {
+        BoundsBatch::transformSpheres(batch.og.arrays(), batch.transforms(), batch.out.outArrays(), 0, batch.count);
+    }
+
+    // Copy to the table
+    for (unsigned int i = 0; i < batch.count; ++i) {
+        if (i + TRANSFORM_PREFETCH_DISTANCE < batch.count) {
+            unsigned int next = batch.handles[i + TRANSFORM_PREFETCH_DISTANCE];
+            prefetchWrite(&minX[next]);
+            prefetchWrite(&minY[next]);
+            prefetchWrite(&minZ[next]);
+            prefetchWrite(&maxX[next]);
+            prefetchWrite(&maxY[next]);
+            prefetchWrite(&maxZ[next]);
+        }
+
+        unsigned int handle = batch.handles[i];
+        minX[handle] = batch.out.minX[i];
+        minY[handle] = batch.out.minY[i];
+        minZ[handle] = batch.out.minZ[i];
+        maxX[handle] = batch.out.maxX[i];
+        maxY[handle] = batch.out.maxY[i];
+        maxZ[handle] = batch.out.maxZ[i];
+    }
+
+    batch.count = 0;
+}
+
+void Octree::ObjectTable::setBox(unsigned int handle, const AABB& box) {
+    minX[handle] = box.min.x;
+    minY[handle] = box.min.y;
+    minZ[handle] = box.min.z;
+    maxX[handle] = box.max.x;
+    maxY[handle] = box.max.y;
+    maxZ[handle] = box.max.z;
+}
+
+void Octree::ObjectTable::setSphere(unsigned int handle, const BoundingSphere& sphere) {
+    setBox(handle, { sphere.center - glm::vec3(sphere.radius), sphere.center + glm::vec3(sphere.radius) });
+}
+
+/*
+    Accessors
+*/
+
+Octree::ObjectBounds Octree::ObjectTable::getBounds(unsigned int handle) {
+    return { getMin(handle), getMax(handle), types[handle], instances[handle] };
+}
+
+BoundingRegion Octree::ObjectTable::getRegion(unsigned int handle) {
+    BoundingRegion ret;
+
+    if (types[handle] == BoundTypes::AABB) {
+        ret = BoundingRegion(og[handle]);
+        ret.min = getMin(handle);
+        ret.max = getMax(handle);
+    }
+    else {
+        ret = BoundingRegion(og[handle].calculateCenter(), (og[handle].max.x - og[handle].min.x) / 2.0f);
+        ret.center = getCenter(handle);
+        ret.radius = (maxX[handle] - minX[handle]) / 2.0f;
+    }
+
+    ret.instance = instances[handle];
+    return ret;
+}
+
+/*
+    Testing methods
+*/
+
+bool Octree::ObjectTable::containedIn(unsigned int handle, BoundingRegion& box) {
+    // Spheres fit when their enclosing box fits
+    return minX[handle] >= box.min.x && maxX[handle] <= box.max.x &&
+        minY[handle] >= box.min.y && maxY[handle] <= box.max.y &&
+        minZ[handle] >= box.min.z && maxZ[handle] <= box.max.z;
+}
+
+bool Octree::ObjectTable::intersectsWith(unsigned int handle, BoundingRegion& box) {
+    AABB region = { box.min, box.max };
+
+    if (types[handle] == BoundTypes::AABB) {
+        return Bounds::intersects(getBox(handle), region);
+    }
+    return Bounds::intersects(getSphere(handle), region);
+}
+
+bool Octree::ObjectTable::intersectsWith(unsigned int a, unsigned int b) {
+    ObjectBounds boundsA = getBounds(a);
+    ObjectBounds boundsB = getBounds(b);
+    return boundsA.intersectsWith(boundsB);
+}
+
+AABB Octree::ObjectBounds::box() {
+    return { min, max };
+}
+
+BoundingSphere Octree::ObjectBounds::sphere() {
+    return { (min + max) / 2.0f, (max.x - min.x) / 2.0f };
+}
+
+bool Octree::ObjectBounds::intersectsWith(ObjectBounds& other) {
+    if (type == BoundTypes::AABB) {
+        return (other.type == BoundTypes::AABB)
+            ? Bounds::intersects(box(), other.box())
+            : Bounds::intersects(box(), other.sphere());
+    }
+    else {
+        return (other.type == BoundTypes::AABB)
+            ? Bounds::intersects(sphere(), other.box())
+            : Bounds::intersects(sphere(), other.sphere());
+    }
+}
+
+/*
+    Transform batch
+*/
+
+Octree::TransformBatch::TransformBatch()
+    : handles(TRANSFORM_BATCH_SIZE),
+    posX(TRANSFORM_BATCH_SIZE), posY(TRANSFORM_BATCH_SIZE), posZ(TRANSFORM_BATCH_SIZE),
+    sizeX(TRANSFORM_BATCH_SIZE), sizeY(TRANSFORM_BATCH_SIZE), sizeZ(TRANSFORM_BATCH_SIZE) {
+    og.resize(TRANSFORM_BATCH_SIZE);
+    out.resize(TRANSFORM_BATCH_SIZE);
+}
+
+void Octree::TransformBatch::add(unsigned int handle, const glm::vec3& pos, const glm::vec3& size,
+    const glm::vec3& min, const glm::vec3& max) {
+    unsigned int i = count++;
+
+    handles[i] = handle;
+    posX[i] = pos.x;
+    posY[i] = pos.y;
+    posZ[i] = pos.z;
+    sizeX[i] = size.x;
+    sizeY[i] = size.y;
+    sizeZ[i] = size.z;
+    og.minX[i] = min.x;
+    og.minY[i] = min.y;
+    og.minZ[i] = min.z;
+    og.maxX[i] = max.x;
+    og.maxY[i] = max.y;
+    og.maxZ[i] = max.z;
+}
+
+BoundsBatch::TransformArrays Octree::TransformBatch::transforms() {
+    return { posX.data(), posY.data(), posZ.data(), sizeX.data(), sizeY.data(), sizeZ.data() };
+}
+
+size_t Octree::TransformBatch::memoryUsage() {
+    return handles.capacity() * sizeof(unsigned int) +
+        (6 * posX.capacity() + 6 * og.minX.capacity() + 6 * out.minX.capacity()) * sizeof(float);
+}
+
+/*
+    Statistics
+*/
+
+unsigned int Octree::ObjectTable::noObjects() {
+    return types.size() - freeList.size();
+}
+
+size_t Octree::ObjectTable::memoryUsage() {
+    size_t ret = 6 * minX.capacity() * sizeof(float);
+    ret += types.capacity() * sizeof(BoundTypes);
+    ret += instances.capacity() * sizeof(RigidBody*);
+    ret += og.capacity() * sizeof(AABB);
+    ret += freeList.capacity() * sizeof(unsigned int);
+    ret += storePos.capacity() * sizeof(unsigned int);
+    for (StoreObjects& objects : stores) {
+        ret += (objects.handles.capacity() + objects.instanceIdx.capacity()) * sizeof(unsigned int);
+    }
+    ret += boxBatch.memoryUsage() + sphereBatch.memoryUsage();
+    return ret;
+}
@@ -0,0 +1,221 @@
+#ifndef OBJECT_TABLE_HPP
+#define OBJECT_TABLE_HPP
+
+#define NULL_OBJECT 0xFFFFFFFF  // Handle of a missing object
+
+#include <vector>
+#include <mutex>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "BoundsBatch.hpp"
+
+namespace Octree {
+    // Bounds of one object gathered from the table (for loops testing it many times)
+    struct ObjectBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+        BoundTypes type;
+        RigidBody* instance;
+
+        // Typed views (spheres are stored as their enclosing box)
+        AABB box();
+        BoundingSphere sphere();
+
+        // Same rules as BoundingRegion::intersectsWith
+        bool intersectsWith(ObjectBounds& other);
+    };
+
+    /*
+        Staging arrays for the batched transform
+        - a chunk of moved objects of one bound type (fixed size, stays in cache)
+        - the transform kernels read og and the transforms, and write out at the same index
+    */
+    struct TransformBatch {
+        std::vector<unsigned int> handles;
+
+        std::vector<float> posX;
+        std::vector<float> posY;
+        std::vector<float> posZ;
+        std::vector<float> sizeX;
+        std::vector<float> sizeY;
+        std::vector<float> sizeZ;
+
+        // Untransformed bounds
+        BoundsBatch::BoxList og;
+        // Transformed bounds (copied to the table by handle)
+        BoundsBatch::BoxList out;
+
+        // Number of staged objects
+        unsigned int count = 0;
+
+        TransformBatch();
+
+        bool full() {
+            return count == handles.size();
+        }
+
+        // Stage handle with its instance transform and untransformed bounds
+        void add(unsigned int handle, const glm::vec3& pos, const glm::vec3& size,
+            const glm::vec3& min, const glm::vec3& max);
+
+        BoundsBatch::TransformArrays transforms();
+
+        // Bytes held by the staging arrays
+        size_t memoryUsage();
+    };
+
+    /*
+        Objects of one InstanceStore and bound type, sorted by instance index
+        - transformMoved reads the store arrays front to back through it
+        - instance indices are refreshed when the store removed instances (InstanceStore::noRemovals)
+    */
+    struct StoreObjects {
+        InstanceStore* store;
+        BoundTypes type;
+
+        std::vector<unsigned int> handles;
+        std::vector<unsigned int> instanceIdx;
+
+        // store->noRemovals when instanceIdx was last checked
+        unsigned int noRemovals;
+
+        // Cleared when an entry is added out of order, swapped on release or its instance moved
+        bool sorted = true;
+
+        StoreObjects(InstanceStore* store, BoundTypes type)
+            : store(store), type(type), noRemovals(store->noRemovals) {}
+    };
+
+    /*
+        Table of objects in an octree
+        - nodes store 32-bit handles into the table
+        - transformed bounds are kept as structure of arrays (minX[], minY[], ...)
+        - spheres are stored as their enclosing box (center and radius are recovered from it)
+        - released handles are recycled through a free list
+    */
+    class ObjectTable {
+    public:
+        // Transformed bounds
+        std::vector<float> minX;
+        std::vector<float> minY;
+        std::vector<float> minZ;
+        std::vector<float> maxX;
+        std::vector<float> maxY;
+        std::vector<float> maxZ;
+
+        std::vector<BoundTypes> types;
+        std::vector<RigidBody*> instances;
+
+        // Untransformed bounds (before instance position and size)
+        std::vector<AABB> og;
+
+        // Add region (with its current transform), returns handle
+        // Counted in RigidBody::noObjects until released
+        unsigned int add(BoundingRegion& br);
+
+        // Return handle to the free list (safe to call from update jobs)
+        void release(unsigned int handle);
+
+        // Remove all objects
+        void clear();
+
+        // Apply instance position and size to bounds
+        void transform(unsigned int handle);
+
+        // Apply instance transforms to every moved object in one pass, returns number transformed
+        // (once per frame before the tree update)
+        unsigned int transformMoved();
+
+        /*
+            Accessors (inline, queries read them for every object they test)
+        */
+
+        glm::vec3 getMin(unsigned int handle) {
+            return glm::vec3(minX[handle], minY[handle], minZ[handle]);
+        }
+
+        glm::vec3 getMax(unsigned int handle) {
+            return glm::vec3(maxX[handle], maxY[handle], maxZ[handle]);
+        }
+
+        glm::vec3 getCenter(unsigned int handle) {
+            return (getMin(handle) + getMax(handle)) / 2.0f;
+        }
+
+        // Typed bounds of handle (caller knows the type)
+        AABB getBox(unsigned int handle) {
+            return { getMin(handle), getMax(handle) };
+        }
+
+        BoundingSphere getSphere(unsigned int handle) {
+            return { getCenter(handle), (maxX[handle] - minX[handle]) / 2.0f };
+        }
+
+        // Gather bounds of handle
+        ObjectBounds getBounds(unsigned int handle);
+
+        // Rebuild region (for callers working with BoundingRegion)
+        BoundingRegion getRegion(unsigned int handle);
+
+        /*
+            Testing methods (same rules as BoundingRegion)
+        */
+
+        // Determine if object is inside box
+        bool containedIn(unsigned int handle, BoundingRegion& box);
+
+        // Determine if object intersects box
+        bool intersectsWith(unsigned int handle, BoundingRegion& box);
+
+        // Determine if objects intersect
+        bool intersectsWith(unsigned int a, unsigned int b);
+
+        /*
+            Statistics
+        */
+
+        // Number of objects in use
+        unsigned int noObjects();
+
+        // Bytes held by the table
+        size_t memoryUsage();
+
+    private:
+        std::vector<unsigned int> freeList;
+
+        // Chunks of moved objects staged by transformMoved
+        TransformBatch boxBatch;
+        TransformBatch sphereBatch;
+
+        // Objects with an instance, grouped by store (few stores, one per model)
+        std::vector<StoreObjects> stores;
+        // Position of each handle in its group
+        std::vector<unsigned int> storePos;
+
+        // Guards freeList and stores while subtrees are updated in parallel
+        std::mutex releaseMutex;
+
+        // Set transformed bounds of handle
+        void setBox(unsigned int handle, const AABB& box);
+        void setSphere(unsigned int handle, const BoundingSphere& sphere);
+
+        // Group of store and type of instance (created on first use, NULL_OBJECT without instance)
+        unsigned int findStore(RigidBody* instance, BoundTypes type);
+
+        // Restore instance order of group
+        void sortStore(StoreObjects& objects);
+
+        // Read instance indices again after the store removed instances
+        void refreshStore(StoreObjects& objects);
+
+        // Stage moved objects of group, streaming the store arrays, returns number staged
+        unsigned int gatherMoved(StoreObjects& objects, TransformBatch& batch);
+
+        // Transform staged objects and copy their bounds to the table, empties batch
+        void flush(TransformBatch& batch);
+    };
+}
+
+#endif //OBJECT_TABLE_HPP
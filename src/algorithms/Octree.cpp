@@ -1,60 +1,372 @@
 #include "Octree.hpp"
 
+// Nesting of timed calls on this thread, recursive calls are timed once
+static thread_local unsigned int buildDepth = 0;
+static thread_local unsigned int updateDepth = 0;
+static thread_local unsigned int processPendingDepth = 0;
+static thread_local unsigned int insertDepth = 0;
+
 void Octree::calculateBounds(BoundingRegion* out, Octant octant, BoundingRegion parentRegion){
     glm::vec3 center = parentRegion.calculateCenter();
         if (octant == Octant::O1) {
-            out = new BoundingRegion(center, parentRegion.max);
+            *out = BoundingRegion(center, parentRegion.max);
         }
         else if (octant == Octant::O2) {
-            out = new BoundingRegion(glm::vec3(parentRegion.min.x, center.y, center.z), glm::vec3(center.x, parentRegion.max.y, parentRegion.max.z));
+            *out = BoundingRegion(glm::vec3(parentRegion.min.x, center.y, center.z), glm::vec3(center.x, parentRegion.max.y, parentRegion.max.z));
         }
         else if (octant == Octant::O3) {
-            out = new BoundingRegion(glm::vec3(parentRegion.min.x, parentRegion.min.y, center.z), glm::vec3(center.x, center.y, parentRegion.max.z));
+            *out = BoundingRegion(glm::vec3(parentRegion.min.x, parentRegion.min.y, center.z), glm::vec3(center.x, center.y, parentRegion.max.z));
         }
         else if (octant == Octant::O4) {
-            out = new BoundingRegion(glm::vec3(center.x, parentRegion.min.y, center.z), glm::vec3(parentRegion.max.x, center.y, parentRegion.max.z));
+            *out = BoundingRegion(glm::vec3(center.x, parentRegion.min.y, center.z), glm::vec3(parentRegion.max.x, center.y, parentRegion.max.z));
         }
         else if (octant == Octant::O5) {
-            out = new BoundingRegion(glm::vec3(center.x, center.y, parentRegion.min.z), glm::vec3(parentRegion.max.x, parentRegion.max.y, center.z));
+            *out = BoundingRegion(glm::vec3(center.x, center.y, parentRegion.min.z), glm::vec3(parentRegion.max.x, parentRegion.max.y, center.z));
         }
         else if (octant == Octant::O6) {
-            out = new BoundingRegion(glm::vec3(parentRegion.min.x, center.y, parentRegion.min.z), glm::vec3(center.x, parentRegion.max.y, center.z));
+            *out = BoundingRegion(glm::vec3(parentRegion.min.x, center.y, parentRegion.min.z), glm::vec3(center.x, parentRegion.max.y, center.z));
         }
         else if (octant == Octant::O7) {
-            out = new BoundingRegion(parentRegion.min, center);
+            *out = BoundingRegion(parentRegion.min, center);
         }
         else if (octant == Octant::O8) {
-            out = new BoundingRegion(glm::vec3(center.x, parentRegion.min.y, parentRegion.min.z), glm::vec3(parentRegion.max.x, center.y, center.z));
+            *out = BoundingRegion(glm::vec3(center.x, parentRegion.min.y, parentRegion.min.z), glm::vec3(parentRegion.max.x, center.y, center.z));
+        }
+}
+
+// Octant index (see calculateBounds) of each triplet of upper halves (x << 2 | y << 1 | z)
+static const int octantIndices[NO_CHILDREN] = { 6, 2, 5, 1, 7, 3, 4, 0 };
+
+// Octant of the child holding point (children of a node centered at center)
+static int octantOf(glm::vec3 point, glm::vec3 center) {
+    return octantIndices[(point.x >= center.x) << 2 | (point.y >= center.y) << 1 | (point.z >= center.z)];
+}
+
+// Distances where ray enters and exits the loose lower (0) and upper (1) halves of region along axis
+// (same arithmetic as calculateBounds and calculateLooseBounds, so the halves are the children's looseRegion)
+static void rayThroughHalves(Ray& ray, BoundingRegion& region, int axis, float looseFactor, float tEnter[2], float tExit[2]) {
+    float center = (region.min[axis] + region.max[axis]) / 2.0f;
+
+    for (int half = 0; half < 2; ++half) {
+        float min = half ? center : region.min[axis];
+        float max = half ? region.max[axis] : center;
+        if (looseFactor > 1.0f) {
+            float halfCenter = (min + max) / 2.0f;
+            float halfDimension = (max - min) * (looseFactor / 2.0f);
+            min = halfCenter - halfDimension;
+            max = halfCenter + halfDimension;
+        }
+
+        if (ray.direction[axis] == 0.0f) {
+            // Parallel to the slab, inside it along the whole ray or never (as in Ray::intersectsWith)
+            bool inside = ray.origin[axis] >= min && ray.origin[axis] <= max;
+            tEnter[half] = inside ? -INFINITY : INFINITY;
+            tExit[half] = inside ? INFINITY : -INFINITY;
+            continue;
         }
+
+        float t1 = (min - ray.origin[axis]) * ray.invDirection[axis];
+        float t2 = (max - ray.origin[axis]) * ray.invDirection[axis];
+        tEnter[half] = std::min(t1, t2);
+        tExit[half] = std::max(t1, t2);
+    }
 }
 
+BoundingRegion Octree::calculateLooseBounds(BoundingRegion region, float looseFactor){
+    if (looseFactor <= 1.0f) {
+        // Regular octree
+        return region;
+    }
+
+    glm::vec3 center = region.calculateCenter();
+    glm::vec3 halfDimensions = region.calculateDimensions() * (looseFactor / 2.0f);
+    return BoundingRegion(center - halfDimensions, center + halfDimensions);
+}
+
+// spread lower 10 bits so there are 2 zero bits between each
+static unsigned int expandBits(unsigned int v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+unsigned int Octree::calculateMortonCode(glm::vec3 pt, BoundingRegion bounds){
+    // Quantize to cell coordinates
+    glm::vec3 cell = (pt - bounds.min) / bounds.calculateDimensions() * (float)(1 << MORTON_BITS);
+    cell = glm::clamp(cell, glm::vec3(0.0f), glm::vec3((float)((1 << MORTON_BITS) - 1)));
+
+    // x is the highest bit of each octant triplet
+    return (expandBits((unsigned int)cell.x) << 2) |
+        (expandBits((unsigned int)cell.y) << 1) |
+        expandBits((unsigned int)cell.z);
+}
+
+int Octree::commonMortonLevels(unsigned int a, unsigned int b){
+    unsigned int diff = a ^ b;
+    for (int level = 0; level < MORTON_BITS; ++level) {
+        // Compare triplet of next level
+        if ((diff >> (3 * (MORTON_BITS - level - 1))) & 0x7) {
+            return level;
+        }
+    }
+    return MORTON_BITS;
+}
+
+/*
+    Node pool
+*/
+
+Octree::NodePool::NodePool(node* root, float looseFactor)
+    : root(root), looseFactor(looseFactor), noMovedObjects(0), noReinsertions(0), noExpiredNodes(0), noPairTests(0),
+    rootOverflow(false), frame(0), profiling(false), noSlots(0) {}
+
+Octree::NodePool::~NodePool() {
+    for (node* block : blocks) {
+        delete[] block;
+    }
+    blocks.clear();
+}
+
+Octree::node* Octree::NodePool::operator[](unsigned int idx) {
+    if (idx == NULL_NODE) {
+        return nullptr;
+    }
+    if (idx == ROOT_NODE) {
+        return root;
+    }
+
+    // Slots are offset by one because index 0 is the root
+    unsigned int slot = idx - 1;
+    return &blocks[slot / POOL_BLOCK_SIZE][slot % POOL_BLOCK_SIZE];
+}
+
+unsigned int Octree::NodePool::allocate(unsigned int parent, BoundingRegion bounds) {
+    unsigned int idx;
+
+    if (freeList.size() > 0) {
+        // Recycle released node
+        idx = freeList.back();
+        freeList.pop_back();
+    }
+    else {
+        if (noSlots == blocks.size() * POOL_BLOCK_SIZE) {
+            // All blocks full
+            blocks.push_back(new node[POOL_BLOCK_SIZE]);
+        }
+        idx = ++noSlots;
+    }
+
+    node* n = (*this)[idx];
+    n->pool = this;
+    n->reset(idx, parent, bounds);
+
+    return idx;
+}
+
+unsigned int Octree::NodePool::release(unsigned int idx) {
+    std::lock_guard<std::mutex> lock(releaseMutex);
+    return releaseNode(idx);
+}
+
+unsigned int Octree::NodePool::releaseNode(unsigned int idx) {
+    if (idx == NULL_NODE || idx == ROOT_NODE) {
+        return 0;
+    }
+
+    node* n = (*this)[idx];
+    unsigned int noReleased = 1;
+
+    // Release children first
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (n->children[i] != NULL_NODE) {
+            noReleased += releaseNode(n->children[i]);
+            n->children[i] = NULL_NODE;
+        }
+    }
+
+    // Keep capacity of the lists so recycled nodes don't allocate
+    for (unsigned int handle : n->objects) {
+        table.release(handle);
+    }
+    n->objects.clear();
+    while (n->queue.size() != 0) {
+        n->queue.pop();
+    }
+    n->activeOctants = 0;
+    n->hasChildren = false;
+    n->parent = NULL_NODE;
+
+    freeList.push_back(idx);
+    return noReleased;
+}
+
+unsigned int Octree::NodePool::noActiveNodes() {
+    return noSlots - freeList.size() + 1; // Include root
+}
+
+unsigned int Octree::NodePool::noFreeNodes() {
+    return freeList.size();
+}
+
+unsigned int Octree::NodePool::capacity() {
+    return blocks.size() * POOL_BLOCK_SIZE;
+}
+
+void Octree::NodePool::resetCounters() {
+    noMovedObjects = 0;
+    noReinsertions = 0;
+    noExpiredNodes = 0;
+    noPairTests = 0;
+
+    buildTimer.reset();
+    updateTimer.reset();
+    processPendingTimer.reset();
+    insertTimer.reset();
+}
+
+float Octree::NodePool::reinsertionRate() {
+    return noMovedObjects == 0 ? 0.0f : (float)noReinsertions / (float)noMovedObjects;
+}
+
+size_t Octree::NodePool::memoryUsage() {
+    size_t ret = blocks.size() * POOL_BLOCK_SIZE * sizeof(node);
+    ret += blocks.capacity() * sizeof(node*);
+    ret += freeList.capacity() * sizeof(unsigned int);
+
+    // Handle lists
+    ret += root->objects.capacity() * sizeof(unsigned int);
+    for (unsigned int i = 1; i <= noSlots; ++i) {
+        ret += (*this)[i]->objects.capacity() * sizeof(unsigned int);
+    }
+    ret += table.memoryUsage();
+
+    return ret;
+}
+
+/*
+    Node
+*/
+
 Octree::node::node()
-    : region(BoundTypes::AABB) {}
+    : pool(nullptr), idx(NULL_NODE), parent(NULL_NODE), activeOctants(0), region(BoundTypes::AABB) {
+        for (int i = 0; i < NO_CHILDREN; ++i) {
+            children[i] = NULL_NODE;
+        }
+    }
+
+Octree::node::node(BoundingRegion bounds, float looseFactor)
+    : pool(nullptr), idx(ROOT_NODE), parent(NULL_NODE), activeOctants(0), region(bounds),
+    looseRegion(calculateLooseBounds(bounds, looseFactor)) {
+        for (int i = 0; i < NO_CHILDREN; ++i) {
+            children[i] = NULL_NODE;
+        }
+        pool = new NodePool(this, looseFactor);
+    }
 
-Octree::node::node(BoundingRegion bounds)
-    : region(bounds) {}
+Octree::node::node(BoundingRegion bounds, std::vector<BoundingRegion> objectList, float looseFactor)
+    : node(bounds, looseFactor) {
+        objects.reserve(objectList.size());
+        for (BoundingRegion& br : objectList) {
+            objects.push_back(pool->table.add(br));
+        }
+    }
 
-Octree::node::node(BoundingRegion bounds, std::vector<BoundingRegion> objectList)
-    : region(bounds) {
-        objects.insert(objects.end(), objectList.begin(), objectList.end());
+Octree::node::~node() {
+    if (idx == ROOT_NODE && pool) {
+        // Root owns the pool
+        delete pool;
+        pool = nullptr;
     }
+}
 
-void Octree::node::addToPending(RigidBody* instance, trie::Trie<Model*> models){
-    // Get all bounding region of model
-    for (BoundingRegion br : models[instance->modelId]->boundingRegions){
+Octree::node* Octree::node::getChild(int i) {
+    return (*pool)[children[i]];
+}
+
+Octree::node* Octree::node::getParent() {
+    return (*pool)[parent];
+}
+
+void Octree::node::reset(unsigned int idx, unsigned int parent, BoundingRegion bounds) {
+    this->idx = idx;
+    this->parent = parent;
+    region = bounds;
+    looseRegion = calculateLooseBounds(bounds, pool->looseFactor);
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        children[i] = NULL_NODE;
+    }
+    activeOctants = 0;
+    hasChildren = false;
+
+    treeReady = false;
+    treeBuilt = false;
+    hasMovedObjects = true;
+
+    maxLifespan = 8;
+    currentLifespan = -1;
+}
+
+Octree::node* Octree::node::createChild(int i, BoundingRegion bounds, std::vector<unsigned int>& objectList) {
+    children[i] = pool->allocate(idx, bounds);
+    States::activateIndex(&activeOctants, i);
+    hasChildren = true;
+
+    node* child = getChild(i);
+    child->objects.insert(child->objects.end(), objectList.begin(), objectList.end());
+
+    // New nodes start flagged, so markMoved from them would stop before reaching this node
+    markMoved();
+    return child;
+}
+
+unsigned int Octree::node::releaseChild(int i) {
+    unsigned int noReleased = pool->release(children[i]);
+    children[i] = NULL_NODE;
+    States::deactivateIndex(&activeOctants, i);
+    hasChildren = activeOctants != 0;
+    return noReleased;
+}
+
+// queue bounds of model for instance (type resolved by the caller)
+template <typename Bound>
+static void queueBounds(std::queue<BoundingRegion>& queue, std::vector<Bound>& bounds, RigidBody* instance) {
+    for (Bound& og : bounds) {
+        BoundingRegion br(og);
         br.instance = instance;
         br.transform();
         queue.push(br);
     }
 }
 
+void Octree::node::addToPending(RigidBody* instance, Model* model){
+    // New instances are tested in the next broad phase
+    States::activate(&instance->state(), INSTANCE_MOVED);
+
+    // Get all bounding region of model
+    if (model->boundType == BoundTypes::AABB) {
+        queueBounds(queue, model->boxBounds, instance);
+    }
+    else {
+        queueBounds(queue, model->sphereBounds, instance);
+    }
+}
+
 void Octree::node::build(){
+    ScopedTimer timer(pool->buildTimer, buildDepth, pool->profiling);
+
     /*
         Termination conditions
         - 1 or less objects (ie an empty leaf node)
         -dimensions are too small
     */
 
+    // Leaves are part of the built tree too
+    treeBuilt = true;
+    treeReady = true;
+
     // <= 1 objects
     if (objects.size() <= 1) {
         return;
@@ -70,22 +382,24 @@ void Octree::node::build(){
 
     // Create regions
     BoundingRegion octants[NO_CHILDREN];
+    BoundingRegion looseOctants[NO_CHILDREN];
     for(int i = 0; i < NO_CHILDREN; ++i){
         calculateBounds(&octants[i], (Octant)(1 << i), region);
+        looseOctants[i] = calculateLooseBounds(octants[i], pool->looseFactor);
     }
 
     // Determine which octants to place object in
-    std::vector<BoundingRegion> octLists[NO_CHILDREN]; // Array of lists of objects in each octant
+    // (the octant holding its center, loose octants overlap so the first one containing it could be a neighbour)
+    std::vector<unsigned int> octLists[NO_CHILDREN]; // Array of lists of objects in each octant
     std::stack<int> delList; // List of objects that have been placed
+    glm::vec3 center = region.calculateCenter();
 
     for(int i = 0, length = objects.size(); i < length; ++i){
-        BoundingRegion br = objects[i];
-        for(int j = 0; j < NO_CHILDREN; ++j){
-            if(octants[j].containsRegion(br)) {
-                octLists[j].push_back(br);
-                delList.push(i);
-                break;
-            }
+        unsigned int handle = objects[i];
+        int j = octantOf(pool->table.getCenter(handle), center);
+        if(pool->table.containedIn(handle, looseOctants[j])) {
+            octLists[j].push_back(handle);
+            delList.push(i);
         }
     }
 
@@ -98,19 +412,148 @@ void Octree::node::build(){
     // Populate octants
     for(int i = 0; i < NO_CHILDREN; ++i){
         if(octLists[i].size() != 0){
-            children[i] = new node(octants[i], octLists[i]);
-            States::activateIndex(&activeOctants, i);
-            children[i]->build();
-            hasChildren = true;
+            createChild(i, octants[i], octLists[i])->build();
         }
     }
+}
+
+void Octree::node::buildLinear(unsigned int noThreads){
+    ScopedTimer timer(pool->buildTimer, buildDepth, pool->profiling);
+
+    /*
+        Bulk build
+        - compute Morton code of each object center (parallel)
+        - radix sort the codes (parallel)
+        - find the level of each object (parallel)
+            - deepest cell containing the whole object
+            - no deeper than needed to separate it from its neighbours in sorted order
+        - walk the sorted list once and place objects in nodes
+    */
 
     treeBuilt = true;
     treeReady = true;
+
+    unsigned int noObjects = objects.size();
+    if (noObjects <= 1) {
+        return;
+    }
+
+    noThreads = Parallel::getNoThreads(noThreads);
+
+    // Deepest level where nodes are still split (same rule as build)
+    int maxLevel = 0;
+    glm::vec3 dimensions = region.calculateDimensions();
+    while (maxLevel < MORTON_BITS &&
+        dimensions.x >= MIN_BOUNDS && dimensions.y >= MIN_BOUNDS && dimensions.z >= MIN_BOUNDS) {
+        dimensions /= 2.0f;
+        ++maxLevel;
+    }
+
+    // Morton codes
+    std::vector<unsigned int> codes(noObjects), order(noObjects);
+    std::vector<int> fitLevels(noObjects);
+    Parallel::forRange(noObjects, noThreads, [&](unsigned int begin, unsigned int end, unsigned int /*t*/) {
+        for (unsigned int i = begin; i < end; ++i) {
+            glm::vec3 min = pool->table.getMin(objects[i]);
+            glm::vec3 max = pool->table.getMax(objects[i]);
+
+            codes[i] = calculateMortonCode((min + max) / 2.0f, region);
+            order[i] = i;
+            // Cells shared by both corners contain the whole object
+            fitLevels[i] = commonMortonLevels(calculateMortonCode(min, region), calculateMortonCode(max, region));
+        }
+    });
+
+    // Sort
+    Parallel::radixSort(codes, order, 3 * MORTON_BITS, noThreads);
+
+    // Levels
+    std::vector<int> levels(noObjects);
+    Parallel::forRange(noObjects, noThreads, [&](unsigned int begin, unsigned int end, unsigned int /*t*/) {
+        for (unsigned int i = begin; i < end; ++i) {
+            int neighbourLevel = -1;
+            if (i > 0) {
+                neighbourLevel = std::max(neighbourLevel, commonMortonLevels(codes[i], codes[i - 1]));
+            }
+            if (i < noObjects - 1) {
+                neighbourLevel = std::max(neighbourLevel, commonMortonLevels(codes[i], codes[i + 1]));
+            }
+
+            levels[i] = std::min(std::min(fitLevels[order[i]], maxLevel), neighbourLevel + 1);
+        }
+    });
+
+    std::vector<unsigned int> objectList;
+    objectList.swap(objects);
+    std::vector<unsigned int> emptyList;
+
+    // Place objects in sorted order
+    for (unsigned int i = 0; i < noObjects; ++i) {
+        unsigned int handle = objectList[order[i]];
+        node* current = this;
+
+        for (int level = 1; level <= levels[i]; ++level) {
+            int octant = octantIndices[(codes[i] >> (3 * (MORTON_BITS - level))) & 0x7];
+
+            if (current->children[octant] == NULL_NODE) {
+                BoundingRegion octantRegion;
+                calculateBounds(&octantRegion, (Octant)(1 << octant), current->region);
+                BoundingRegion looseOctant = calculateLooseBounds(octantRegion, pool->looseFactor);
+                if (!pool->table.containedIn(handle, looseOctant)) {
+                    // Quantization disagrees with exact bounds, keep in current
+                    break;
+                }
+
+                node* child = current->createChild(octant, octantRegion, emptyList);
+                child->treeBuilt = true;
+                child->treeReady = true;
+            }
+            else if (!pool->table.containedIn(handle, current->getChild(octant)->looseRegion)) {
+                break;
+            }
+
+            current = current->getChild(octant);
+        }
+
+        current->objects.push_back(handle);
+    }
 }
 
 void Octree::node::update(){
+    ScopedTimer timer(pool->updateTimer, updateDepth, pool->profiling);
+    updateNode(NULL_NODE, nullptr, 1);
+}
+
+void Octree::node::updateParallel(unsigned int noThreads){
+    ScopedTimer timer(pool->updateTimer, updateDepth, pool->profiling);
+    updateNode(NULL_NODE, nullptr, Parallel::getNoThreads(noThreads));
+}
+
+void Octree::node::updateNode(unsigned int subtreeRoot, std::vector<unsigned int>* deferred, unsigned int noThreads){
+    if (idx == ROOT_NODE) {
+        // New update pass
+        pool->resetCounters();
+        ++pool->frame;
+
+        // World-space bounds of every moved object in one pass
+        pool->table.transformMoved();
+    }
+
     if (treeBuilt && treeReady) {
+        // Insert objects added since the tree was built
+        if (queue.size() > 0) {
+            processPending();
+        }
+
+        // Remove objects of dead instances
+        ObjectTable& table = pool->table;
+        for (int i = objects.size() - 1; i >= 0; --i) {
+            if (States::isActive(&table.instances[objects[i]]->state(), INSTANCE_DEAD)) {
+                table.release(objects[i]);
+                objects.erase(objects.begin() + i);
+            }
+        }
+
         // Countdown timer
         if (objects.size() == 0){
             if(!hasChildren) {
@@ -135,51 +578,94 @@ void Octree::node::update(){
         }
 
         // Get moved objects that were in this leaf in previous frame
-        std::stack<std::pair<int, BoundingRegion>> movedObjects;
+        std::stack<int> movedObjects;
+        unsigned int noMoved = 0;
 
         for (int i = 0, listSize = objects.size(); i < listSize; ++i) {
-            if (States::isActive(&objects[i].instance->state, INSTANCE_MOVED)) {
-                objects[i].transform();
-                movedObjects.push({ i, objects[i] });
+            if (States::isActive(&table.instances[objects[i]]->state(), INSTANCE_MOVED)) {
+                // Bounds were transformed by the root
+                ++noMoved;
+
+                if (pool->looseFactor > 1.0f && table.containedIn(objects[i], looseRegion)) {
+                    // Still inside loose bounds, no need to migrate
+                    continue;
+                }
+
+                movedObjects.push(i);
             }
         }
 
+        if (noMoved > 0) {
+            pool->noMovedObjects += noMoved;
+            // Moved objects staying here still need collision checks
+            markMoved();
+        }
+
         // Remove dead branches
         unsigned char flags = activeOctants;
         for (int i = 0;
             flags > 0;
             flags >>= 1, ++i){
-            if (States::isIndexActive(&flags, 0) && children[i]->currentLifespan == 0) {
+            if (States::isIndexActive(&flags, 0) && getChild(i)->currentLifespan == 0) {
                 // Active and out of time
-                if (children[i]->objects.size() > 0){
+                if (getChild(i)->objects.size() > 0){
                     // Branch is dead but has children. so reset
-                    children[i]->currentLifespan = -1;
+                    getChild(i)->currentLifespan = -1;
                 }
                 else {
-                    // Branch is dead
-                    children[i] = nullptr;
-                    States::deactivateIndex(&activeOctants, i);
+                    // Branch is dead, recycle its nodes
+                    pool->noExpiredNodes += releaseChild(i);
                 }
             }
         }
 
         // Update child nodes
-        if(children != nullptr){
+        unsigned int jobs[NO_CHILDREN];
+        unsigned int noJobs = 0;
+        if (noThreads > 1) {
+            for (int i = 0; i < NO_CHILDREN; ++i) {
+                if (States::isIndexActive(&activeOctants, i) && children[i] != NULL_NODE) {
+                    jobs[noJobs++] = children[i];
+                }
+            }
+        }
+
+        if (noJobs > 1) {
+            // Every child subtree is an independent job on the shared pool
+            // children get a share of the threads and split again until the frontier has noThreads subtrees
+            unsigned int childThreads = (noThreads + noJobs - 1) / noJobs;
+            std::vector<unsigned int> deferredObjects[NO_CHILDREN];
+
+            // Jobs marking moved objects stop at this node
+            markMoved();
+
+            Parallel::getPool().run(noJobs, [&](unsigned int j) {
+                (*pool)[jobs[j]]->updateNode(jobs[j], &deferredObjects[j], childThreads);
+            });
+
+            // Serial merge of objects that left their subtree
+            for (unsigned int j = 0; j < noJobs; ++j) {
+                for (unsigned int handle : deferredObjects[j]) {
+                    reinsertObject(handle, subtreeRoot, deferred);
+                }
+            }
+        }
+        else {
             for(unsigned char flags = activeOctants, i = 0;
                 flags > 0;
                 flags >>= 1, ++i) {
                 if(States::isIndexActive(&flags, 0)){
                     // Active octant
-                    if (children[i] != nullptr){
-                        // Child not null
-                        children[i]->update();
+                    if (children[i] != NULL_NODE){
+                        // Child allocated (single child keeps splitting with all threads)
+                        getChild(i)->updateNode(subtreeRoot, deferred, noThreads);
                     }
                 }
             }
         }
 
         // Move moved objects into new nodes
-        BoundingRegion movedObj;
+        unsigned int movedObj;
         while (movedObjects.size() != 0){
             /*
                 for each movec object
@@ -187,17 +673,7 @@ void Octree::node::update(){
                 - call insert (push object as far down as possible)
             */
         
-            movedObj = movedObjects.top().second; // Set to top object in stack
-            node* current = this;
-
-            while(!current->region.containsRegion(movedObj)){
-                if(current->parent != nullptr) {
-                    current = current->parent;
-                }
-                else {
-                    break; // If root node, the leave
-                }
-            }
+            movedObj = objects[movedObjects.top()]; // Set to top object in stack
 
             /*
                 Once finished
@@ -205,12 +681,10 @@ void Octree::node::update(){
                 - remove from movedObjects stack
                 - insert into found region
             */
-            objects.erase(objects.begin() + movedObjects.top().first);
+            objects.erase(objects.begin() + movedObjects.top());
             movedObjects.pop();
-            current->insert(movedObj);
-
-            // Collision detection
-            // TODO
+            reinsertObject(movedObj, subtreeRoot, deferred);
+            ++pool->noReinsertions;
         }
 
     }
@@ -220,27 +694,151 @@ void Octree::node::update(){
             processPending();
         }
     }
+
+    if (idx == ROOT_NODE) {
+        if (pool->rootOverflow) {
+            // Objects left the world, grow the root and sort everything again
+            pool->rootOverflow = false;
+            if (growToFit()) {
+                std::vector<unsigned int> handles;
+                takeObjects(handles);
+                objects.swap(handles);
+
+                if (objects.size() >= LINEAR_BUILD_THRESHOLD) {
+                    buildLinear();
+                }
+                else {
+                    build();
+                }
+                markMoved();
+            }
+        }
+
+        // Collision detection
+        broadPhase();
+    }
+}
+
+bool Octree::node::growToFit(){
+    // Bounds of the objects outside of the root
+    ObjectTable& table = pool->table;
+    glm::vec3 outsideMin = region.min;
+    glm::vec3 outsideMax = region.max;
+    bool outside = false;
+
+    for (unsigned int handle : objects) {
+        if (table.containedIn(handle, looseRegion)) {
+            continue;
+        }
+
+        glm::vec3 objMin = table.getMin(handle);
+        glm::vec3 objMax = table.getMax(handle);
+        if (!std::isfinite(objMin.x + objMin.y + objMin.z + objMax.x + objMax.y + objMax.z)) {
+            // Can't be enclosed, stays in the root's list
+            continue;
+        }
+
+        outsideMin = glm::min(outsideMin, objMin);
+        outsideMax = glm::max(outsideMax, objMax);
+        outside = true;
+    }
+
+    if (!outside) {
+        return false;
+    }
+
+    // Old region stays an octant of the new one (towards the objects on each axis)
+    glm::vec3 min = region.min;
+    glm::vec3 max = region.max;
+    while (glm::any(glm::lessThan(outsideMin, min)) || glm::any(glm::greaterThan(outsideMax, max))) {
+        glm::vec3 size = max - min;
+        for (int i = 0; i < 3; ++i) {
+            if (outsideMin[i] < min[i]) {
+                min[i] -= size[i];
+            }
+            else {
+                max[i] += size[i];
+            }
+        }
+    }
+
+    region = BoundingRegion(min, max);
+    looseRegion = calculateLooseBounds(region, pool->looseFactor);
+    return true;
+}
+
+void Octree::node::takeObjects(std::vector<unsigned int>& handles){
+    handles.insert(handles.end(), objects.begin(), objects.end());
+    objects.clear();
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (children[i] != NULL_NODE) {
+            getChild(i)->takeObjects(handles);
+            releaseChild(i);
+        }
+    }
+}
+
+void Octree::node::reinsertObject(unsigned int obj, unsigned int subtreeRoot, std::vector<unsigned int>* deferred){
+    // Traverse up the tree until a node encloses the object
+    node* current = this;
+    while(!pool->table.containedIn(obj, current->looseRegion)){
+        if (deferred && current->idx == subtreeRoot) {
+            // Outside of this job's subtree, merged by the caller
+            deferred->push_back(obj);
+            return;
+        }
+        else if(current->parent != NULL_NODE) {
+            current = current->getParent();
+        }
+        else {
+            break; // If root node, the leave
+        }
+    }
+
+    // Jobs can't grow the pool, the object stays in the deepest existing node
+    current->insertObject(obj, deferred == nullptr);
 }
 
 void Octree::node::processPending(){
+    ScopedTimer timer(pool->processPendingTimer, processPendingDepth, pool->profiling);
+
     if (!treeBuilt){
         // Add objects to be sorted into branches when built
         while (queue.size() != 0){
-            objects.push_back(queue.front());
+            objects.push_back(pool->table.add(queue.front()));
             queue.pop();
         }
-        build();
+
+        if (idx == ROOT_NODE) {
+            // Start with a root enclosing every object
+            growToFit();
+        }
+
+        if (objects.size() >= LINEAR_BUILD_THRESHOLD) {
+            // Large loads use the parallel bulk build
+            buildLinear();
+        }
+        else {
+            build();
+        }
     }
     else {
         // Insert the objects immediately
         while(queue.size() != 0){
-            insert(queue.front());
+            insertObject(pool->table.add(queue.front()));
             queue.pop();
         }
     }
 }
 
 bool Octree::node::insert(BoundingRegion obj){
+    return insertObject(pool->table.add(obj));
+}
+
+bool Octree::node::insertObject(unsigned int obj, bool allowAllocation){
+    ScopedTimer timer(pool->insertTimer, insertDepth, pool->profiling);
+
     /*
         Termination conditions
         - no objects (an empty leaf node)
@@ -254,63 +852,497 @@ bool Octree::node::insert(BoundingRegion obj){
             dimensions.z < MIN_BOUNDS
     ){
             objects.push_back(obj);
+            markMoved();
             return true;
     }
 
     // Safe guard if object doesn't fit
-    if (!region.containsRegion(obj)) {
-        return parent == nullptr ? false : parent->insert(obj);
+    if (!pool->table.containedIn(obj, looseRegion)) {
+        if (parent == NULL_NODE) {
+            // Outside of the root, keep it here so it is still tested until the root grows
+            objects.push_back(obj);
+            markMoved();
+            pool->rootOverflow = true;
+            return true;
+        }
+        return getParent()->insertObject(obj, allowAllocation);
     }
 
-    // Create regions if not defined
-    BoundingRegion octants[NO_CHILDREN];
-    for(int i = 0; i < NO_CHILDREN; ++i) {
-        if(children[i] != nullptr) {
-            octants[i] = children[i]->region;
-        }
-        else {
-            calculateBounds(&octants[i], (Octant)(1 << i), region);
-        }
+    // Find region that fits item entirely (the octant holding its center, as in build)
+    int i = octantOf(pool->table.getCenter(obj), region.calculateCenter());
+
+    // Create region if not defined
+    BoundingRegion octant;
+    BoundingRegion looseOctant;
+    if (children[i] != NULL_NODE) {
+        looseOctant = getChild(i)->looseRegion;
+    }
+    else {
+        calculateBounds(&octant, (Octant)(1 << i), region);
+        looseOctant = calculateLooseBounds(octant, pool->looseFactor);
     }
 
-    // Find region that fits item entirely
-    for(int i = 0; i < NO_CHILDREN; ++i){
-        if (octants[i].containsRegion(obj)){
-            if (children[i] != nullptr){
-                return children[i]->insert(obj);
-            }
-            else {
-                // Create node for child
-                children[i] = new node(octants[i], { obj });
-                States::activateIndex(&activeOctants, i);
-                return true;
-            }
+    if (pool->table.containedIn(obj, looseOctant)){
+        if (children[i] != NULL_NODE){
+            return getChild(i)->insertObject(obj, allowAllocation);
+        }
+        else if (allowAllocation) {
+            // Create node for child
+            std::vector<unsigned int> objectList = { obj };
+            node* child = createChild(i, octant, objectList);
+            child->treeBuilt = true;
+            child->treeReady = true;
+            return true;
         }
     }
     // Doesn't fit into children
     objects.push_back(obj);
+    markMoved();
     return true;
 }
 
 void Octree::node::destroy(){
-    // Clearing out children
-    if(children != nullptr) {
-        for(int flags = activeOctants, i = 0;
-            flags > 0;
-            flags >> 1, ++i){
-                if (States::isActive(&flags, 0)){
-                    // Active
-                    if (children[i] != nullptr){
-                        children[i]->destroy();
-                        children[i] = nullptr;
-                    }
-                }
-            }
+    // Clearing out children (returned to the pool)
+    for(int i = 0; i < NO_CHILDREN; ++i){
+        if (children[i] != NULL_NODE){
+            releaseChild(i);
+        }
     }
 
     // Clear this node
+    for (unsigned int handle : objects) {
+        pool->table.release(handle);
+    }
     objects.clear();
     while (queue.size() != 0){
         queue.pop();
     }
-}
\ No newline at end of file
+}
+
+/*
+    Queries
+*/
+
+// add instance to list if not already added this pass
+static void markVisible(RigidBody* instance, std::vector<RigidBody*>& visible) {
+    if (!States::isActive(&instance->state(), INSTANCE_VISIBLE)) {
+        States::activate(&instance->state(), INSTANCE_VISIBLE);
+        visible.push_back(instance);
+    }
+}
+
+void Octree::node::cull(Frustum& frustum, std::vector<RigidBody*>& visible){
+    // Loose region encloses every object in the subtree
+    // (except for the root, which also keeps objects that are outside of it)
+    FrustumTest test = frustum.classify(looseRegion);
+    bool isRoot = idx == ROOT_NODE;
+
+    if (test == FrustumTest::OUTSIDE && !isRoot) {
+        return;
+    }
+
+    if (test == FrustumTest::INSIDE && !isRoot) {
+        // No per object tests needed
+        collectAll(visible);
+        return;
+    }
+
+    ObjectTable& table = pool->table;
+    for (unsigned int handle : objects) {
+        bool inside = (table.types[handle] == BoundTypes::AABB)
+            ? frustum.intersectsWith(table.getBox(handle))
+            : frustum.intersectsWith(table.getSphere(handle));
+        if (inside) {
+            markVisible(table.instances[handle], visible);
+        }
+    }
+
+    if (test == FrustumTest::OUTSIDE) {
+        // Children are outside too
+        return;
+    }
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (children[i] != NULL_NODE) {
+            if (test == FrustumTest::INSIDE) {
+                getChild(i)->collectAll(visible);
+            }
+            else {
+                getChild(i)->cull(frustum, visible);
+            }
+        }
+    }
+}
+
+void Octree::node::collectAll(std::vector<RigidBody*>& visible){
+    for (unsigned int handle : objects) {
+        markVisible(pool->table.instances[handle], visible);
+    }
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (children[i] != NULL_NODE) {
+            getChild(i)->collectAll(visible);
+        }
+    }
+}
+
+/*
+    Broad phase
+*/
+
+// normalized pair order so duplicates can be removed
+static bool comparePairs(const Octree::CollisionPair& p1, const Octree::CollisionPair& p2) {
+    return p1.a < p2.a || (p1.a == p2.a && p1.b < p2.b);
+}
+
+// test objects and record pair if they overlap
+static void testPair(Octree::NodePool* pool, Octree::ObjectBounds& a, Octree::ObjectBounds& b) {
+    if (a.instance == b.instance) {
+        // Regions of the same instance
+        return;
+    }
+
+    ++pool->noPairTests;
+    if (a.intersectsWith(b)) {
+        if (a.instance < b.instance) {
+            pool->collisionPairs.push_back({ a.instance, b.instance });
+        }
+        else {
+            pool->collisionPairs.push_back({ b.instance, a.instance });
+        }
+    }
+}
+
+// record pair of objects whose boxes overlap
+static void recordPair(Octree::NodePool* pool, Octree::ObjectBounds& a, Octree::ObjectBounds& b) {
+    if (a.instance == b.instance) {
+        return;
+    }
+
+    // Overlapping boxes are exact for boxes, spheres need their own test
+    if ((a.type == BoundTypes::SPHERE || b.type == BoundTypes::SPHERE) && !a.intersectsWith(b)) {
+        return;
+    }
+
+    if (a.instance < b.instance) {
+        pool->collisionPairs.push_back({ a.instance, b.instance });
+    }
+    else {
+        pool->collisionPairs.push_back({ b.instance, a.instance });
+    }
+}
+
+void Octree::node::broadPhase(){
+    // Pairs of instances that didn't move are still valid, only retest the others
+    std::vector<CollisionPair>& pairs = pool->collisionPairs;
+    pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [](CollisionPair& pair) -> bool {
+        unsigned char mask = INSTANCE_MOVED | INSTANCE_DEAD;
+        return (pair.a->state() & mask) || (pair.b->state() & mask);
+    }), pairs.end());
+    pool->broadPhaseStack.clear();
+    pool->broadPhaseBoxes.clear();
+    pool->broadPhaseMoved.clear();
+    pool->broadPhaseMovedBoxes.clear();
+
+    checkCollisions();
+
+    // Instances with several regions can be reported more than once
+    std::sort(pool->collisionPairs.begin(), pool->collisionPairs.end(), comparePairs);
+    pool->collisionPairs.erase(std::unique(pool->collisionPairs.begin(), pool->collisionPairs.end()),
+        pool->collisionPairs.end());
+}
+
+void Octree::node::markMoved(){
+    // Ancestors of a flagged node are always flagged
+    for (node* current = this; current && !current->hasMovedObjects; current = current->getParent()) {
+        current->hasMovedObjects = true;
+    }
+}
+
+void Octree::node::checkCollisions(){
+    if (!hasMovedObjects && pool->broadPhaseMoved.empty()) {
+        // Nothing in this subtree or above it moved
+        return;
+    }
+    hasMovedObjects = false;
+
+    if (pool->looseFactor > 1.0f) {
+        // Loose regions of siblings overlap, so ancestors aren't enough
+        for (unsigned int handle : objects) {
+            if (States::isActive(&pool->table.instances[handle]->state(), INSTANCE_MOVED)) {
+                ObjectBounds bounds = pool->table.getBounds(handle);
+                pool->root->findOverlaps(handle, bounds);
+            }
+        }
+
+        for (int i = 0; i < NO_CHILDREN; ++i) {
+            if (children[i] != NULL_NODE) {
+                getChild(i)->checkCollisions();
+            }
+        }
+        return;
+    }
+
+    // Objects of this node follow the ancestors' on the stack, moved ones first
+    // (gathered once, so the loops below read contiguous memory)
+    std::vector<ObjectBounds>& stack = pool->broadPhaseStack;
+    BoundsBatch::BoxList& boxes = pool->broadPhaseBoxes;
+    std::vector<ObjectBounds>& moved = pool->broadPhaseMoved;
+    BoundsBatch::BoxList& movedBoxes = pool->broadPhaseMovedBoxes;
+    std::vector<unsigned int>& hits = pool->broadPhaseHits;
+    unsigned int noAncestors = stack.size();
+    unsigned int noMovedAncestors = moved.size();
+
+    for (unsigned int handle : objects) {
+        stack.push_back(pool->table.getBounds(handle));
+    }
+    unsigned int length = stack.size();
+    unsigned int firstUnmoved = std::partition(stack.begin() + noAncestors, stack.end(), [](ObjectBounds& bounds) -> bool {
+        return States::isActive(&bounds.instance->state(), INSTANCE_MOVED);
+    }) - stack.begin();
+
+    for (unsigned int i = noAncestors; i < length; ++i) {
+        boxes.push_back(stack[i].min, stack[i].max);
+    }
+    for (unsigned int i = noAncestors; i < firstUnmoved; ++i) {
+        moved.push_back(stack[i]);
+        movedBoxes.push_back(stack[i].min, stack[i].max);
+    }
+
+    if (hits.size() < length) {
+        hits.resize(length);
+    }
+
+    // Moved objects test every later object in this node (moved or not) and every ancestor
+    for (unsigned int i = noAncestors; i < firstUnmoved; ++i) {
+        unsigned int noHits = BoundsBatch::intersectBoxes(stack[i].min, stack[i].max, boxes.arrays(),
+            i + 1, length, hits.data());
+        noHits += BoundsBatch::intersectBoxes(stack[i].min, stack[i].max, boxes.arrays(),
+            0, noAncestors, hits.data() + noHits);
+        pool->noPairTests += length - i - 1 + noAncestors;
+
+        for (unsigned int k = 0; k < noHits; ++k) {
+            recordPair(pool, stack[i], stack[hits[k]]);
+        }
+    }
+
+    // Unmoved objects only need the moved ancestors
+    // (batched over whichever side is longer, so there are fewer kernel calls)
+    unsigned int noUnmoved = length - firstUnmoved;
+    if (noUnmoved <= noMovedAncestors) {
+        if (hits.size() < noMovedAncestors) {
+            hits.resize(noMovedAncestors);
+        }
+
+        for (unsigned int i = firstUnmoved; i < length; ++i) {
+            unsigned int noHits = BoundsBatch::intersectBoxes(stack[i].min, stack[i].max, movedBoxes.arrays(),
+                0, noMovedAncestors, hits.data());
+            for (unsigned int k = 0; k < noHits; ++k) {
+                recordPair(pool, stack[i], moved[hits[k]]);
+            }
+        }
+    }
+    else {
+        for (unsigned int j = 0; j < noMovedAncestors; ++j) {
+            unsigned int noHits = BoundsBatch::intersectBoxes(moved[j].min, moved[j].max, boxes.arrays(),
+                firstUnmoved, length, hits.data());
+            for (unsigned int k = 0; k < noHits; ++k) {
+                recordPair(pool, moved[j], stack[hits[k]]);
+            }
+        }
+    }
+    pool->noPairTests += noUnmoved * noMovedAncestors;
+
+    if (hasChildren) {
+        // Children test against this node's objects too
+        for (int i = 0; i < NO_CHILDREN; ++i) {
+            if (children[i] != NULL_NODE) {
+                getChild(i)->checkCollisions();
+            }
+        }
+    }
+
+    stack.resize(noAncestors);
+    boxes.resize(noAncestors);
+    moved.resize(noMovedAncestors);
+    movedBoxes.resize(noMovedAncestors);
+}
+
+void Octree::node::findOverlaps(unsigned int handle, ObjectBounds& bounds){
+    if (idx != ROOT_NODE && !pool->table.intersectsWith(handle, looseRegion)) {
+        // Root also keeps objects outside of its region
+        return;
+    }
+
+    for (unsigned int other : objects) {
+        if (other != handle) {
+            ObjectBounds otherBounds = pool->table.getBounds(other);
+            testPair(pool, bounds, otherBounds);
+        }
+    }
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (children[i] != NULL_NODE) {
+            getChild(i)->findOverlaps(handle, bounds);
+        }
+    }
+}
+
+/*
+    Statistics
+*/
+
+Octree::Stats Octree::node::collectStats(){
+    Stats stats;
+    collectStats(stats, 0);
+
+    if (stats.noNodes > 0) {
+        stats.averageDepth /= stats.noNodes;
+    }
+    if (stats.noObjects > 0) {
+        stats.averageObjectDepth /= stats.noObjects;
+    }
+
+    stats.frame = pool->frame;
+    stats.memoryUsage = pool->memoryUsage();
+
+    stats.noMovedObjects = pool->noMovedObjects;
+    stats.noReinsertions = pool->noReinsertions;
+    stats.noExpiredNodes = pool->noExpiredNodes;
+    stats.noPairTests = pool->noPairTests;
+    stats.noCollisionPairs = pool->collisionPairs.size();
+
+    stats.buildTime = pool->buildTimer.milliseconds();
+    stats.updateTime = pool->updateTimer.milliseconds();
+    stats.processPendingTime = pool->processPendingTimer.milliseconds();
+    stats.insertTime = pool->insertTimer.milliseconds();
+    stats.noInsertCalls = pool->insertTimer.noCalls;
+
+    return stats;
+}
+
+void Octree::node::collectStats(Stats& stats, unsigned int depth){
+    unsigned int noObjects = objects.size();
+
+    ++stats.noNodes;
+    if (!hasChildren) {
+        ++stats.noLeaves;
+    }
+    stats.noObjects += noObjects;
+    stats.maxDepth = std::max(stats.maxDepth, depth);
+
+    // Sums, divided by collectStats()
+    stats.averageDepth += depth;
+    stats.averageObjectDepth += depth * noObjects;
+
+    ++stats.nodesPerDepth[std::min(depth, (unsigned int)STATS_DEPTH_BUCKETS - 1)];
+    ++stats.objectsPerNode[std::min(noObjects, (unsigned int)STATS_OBJECT_BUCKETS - 1)];
+
+    for (int i = 0; i < NO_CHILDREN; ++i) {
+        if (children[i] != NULL_NODE) {
+            getChild(i)->collectStats(stats, depth + 1);
+        }
+    }
+}
+
+/*
+    Ray casts
+*/
+
+bool Octree::node::castRay(Ray& ray, RayHit& hit, float maxDistance){
+    hit.instance = nullptr;
+    hit.distance = maxDistance;
+
+    return findRayHit(ray, hit);
+}
+
+bool Octree::node::castSegment(glm::vec3 start, glm::vec3 end, RayHit& hit){
+    float length = glm::length(end - start);
+    if (length == 0.0f) {
+        hit.instance = nullptr;
+        hit.distance = 0.0f;
+        return false;
+    }
+
+    Ray ray(start, end - start);
+    return castRay(ray, hit, length);
+}
+
+void Octree::node::castRays(std::vector<Ray>& rays, std::vector<RayHit>& hits, float maxDistance, unsigned int noThreads){
+    hits.resize(rays.size());
+
+    // Queries don't modify the tree, so threads can share it
+    Parallel::forRange(rays.size(), Parallel::getNoThreads(noThreads),
+        [&](unsigned int begin, unsigned int end, unsigned int /*t*/) {
+            for (unsigned int i = begin; i < end; ++i) {
+                castRay(rays[i], hits[i], maxDistance);
+            }
+        });
+}
+
+bool Octree::node::findRayHit(Ray& ray, RayHit& hit){
+    bool ret = false;
+    float entry;
+
+    // Objects in this node can be anywhere in its region
+    ObjectTable& table = pool->table;
+    for (unsigned int handle : objects) {
+        bool hitObject = (table.types[handle] == BoundTypes::AABB)
+            ? ray.intersectsWith(table.getBox(handle), entry, hit.distance)
+            : ray.intersectsWith(table.getSphere(handle), entry, hit.distance);
+        if (hitObject && entry < hit.distance) {
+            hit.instance = table.instances[handle];
+            hit.distance = entry;
+            ret = true;
+        }
+    }
+
+    if (!hasChildren) {
+        return ret;
+    }
+
+    // Sort children by distance the ray enters them (insertion sort, at most 8)
+    // children share their slabs on each axis, so the slab test runs once per half instead of once per child
+    // (and the children's regions aren't read, each one would be a cache miss)
+    float tEnter[3][2];
+    float tExit[3][2];
+    for (int axis = 0; axis < 3; ++axis) {
+        rayThroughHalves(ray, region, axis, pool->looseFactor, tEnter[axis], tExit[axis]);
+    }
+
+    std::pair<float, int> order[NO_CHILDREN];
+    int noHitChildren = 0;
+    for (int halves = 0; halves < NO_CHILDREN; ++halves) {
+        int i = octantIndices[halves];
+        if (children[i] == NULL_NODE) {
+            continue;
+        }
+
+        // Upper half on each axis
+        int x = (halves >> 2) & 1, y = (halves >> 1) & 1, z = halves & 1;
+        float childEnter = std::max(std::max(std::max(-INFINITY, tEnter[0][x]), tEnter[1][y]), tEnter[2][z]);
+        float childExit = std::min(std::min(std::min(INFINITY, tExit[0][x]), tExit[1][y]), tExit[2][z]);
+        if (!(childExit < 0.0f || childEnter > childExit || childEnter > hit.distance)) {
+            entry = std::max(childEnter, 0.0f);
+            int j = noHitChildren++;
+            while (j > 0 && order[j - 1].first > entry) {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = { entry, i };
+        }
+    }
+
+    for (int i = 0; i < noHitChildren; ++i) {
+        if (order[i].first >= hit.distance) {
+            // Everything left is behind the closest hit
+            break;
+        }
+
+        if (getChild(order[i].second)->findRayHit(ray, hit)) {
+            ret = true;
+        }
+    }
+
+    return ret;
+}
@@ -3,15 +3,34 @@
 
 #define NO_CHILDREN 8
 #define MIN_BOUNDS 0.5
+#define LOOSE_FACTOR 1.25f  // Default inflation of node regions (objects straddling split planes still sink)
+
+// Node pool switches
+#define NULL_NODE           0xFFFFFFFF  // Index of a missing node
+#define ROOT_NODE           0x00000000  // Index reserved for the root node
+#define POOL_BLOCK_SIZE     256         // Nodes allocated per pool block
+
+// Linear (Morton coded) build switches
+#define MORTON_BITS             10      // Bits per axis (max depth of linear build)
+#define LINEAR_BUILD_THRESHOLD  4096    // Pending objects before processPending uses buildLinear
 
 #include <vector>
 #include <queue>
 #include <stack>
+#include <cfloat>
+#include <cmath>
+#include <atomic>
+#include <mutex>
 
 #include "List.hpp"
 #include "States.hpp"
 #include "Bounds.hpp"
-#include "Trie.hpp"
+#include "Parallel.hpp"
+#include "Frustum.hpp"
+#include "Ray.hpp"
+#include "OctreeStats.hpp"
+#include "ObjectTable.hpp"
+#include "BoundsBatch.hpp"
 
 #include "../graphics/Model.hpp"
 
@@ -34,11 +53,136 @@ namespace Octree {
    //calculate bounds of specified quadrant in bounding region
     void calculateBounds(BoundingRegion* out, Octant octant, BoundingRegion parentRegion);
 
+    // calculate region inflated by factor around its center (loose octree)
+    BoundingRegion calculateLooseBounds(BoundingRegion region, float looseFactor);
+
+    // calculate Morton code (interleaved cell coordinates) of point in bounds
+    unsigned int calculateMortonCode(glm::vec3 pt, BoundingRegion bounds);
+
+    // number of leading octant levels shared by two Morton codes
+    int commonMortonLevels(unsigned int a, unsigned int b);
+
+    class node;
+
+    // Pair of instances with overlapping bounding regions
+    struct CollisionPair {
+        RigidBody* a;
+        RigidBody* b;
+
+        bool operator==(const CollisionPair& pair) const {
+            return a == pair.a && b == pair.b;
+        }
+    };
+
+    /*
+        Pool of octree nodes
+        - nodes live in fixed size blocks, so addresses stay valid when the pool grows
+        - nodes refer to each other with 32-bit indices
+        - released nodes are recycled through a free list
+        - holds the object table, settings and counters shared by the whole tree
+    */
+    class NodePool {
+    public:
+        // Root of the tree (index ROOT_NODE)
+        node* root;
+
+        // Bounds of all objects in the tree (nodes hold handles into it)
+        ObjectTable table;
+
+        // Factor node regions are inflated by when testing containment (1 = regular octree)
+        float looseFactor;
+
+        // Counters for the last update (reset by the root, shared by update jobs)
+        std::atomic<unsigned int> noMovedObjects;   // objects flagged INSTANCE_MOVED
+        std::atomic<unsigned int> noReinsertions;   // moved objects that left their node
+        std::atomic<unsigned int> noExpiredNodes;   // nodes released after their lifespan ran out
+        unsigned int noPairTests;       // intersection tests in the broad phase
+
+        // Objects were kept in the root outside of its region (the root grows at the end of the update)
+        bool rootOverflow;
+
+        // Number of root updates
+        unsigned int frame;
+
+        // Time build, update, processPending and insert calls (off by default)
+        bool profiling;
+        Timer buildTimer;
+        Timer updateTimer;
+        Timer processPendingTimer;
+        Timer insertTimer;
+
+        // Overlapping pairs after the last broad phase (reused between frames)
+        std::vector<CollisionPair> collisionPairs;
+
+        NodePool(node* root, float looseFactor = LOOSE_FACTOR);
+
+        ~NodePool();
+
+        // Get node at index (nullptr if NULL_NODE)
+        node* operator[](unsigned int idx);
+
+        // Get a node from the free list (or a new block) and initialize it
+        unsigned int allocate(unsigned int parent, BoundingRegion bounds);
+
+        // Return node and its children to the free list (safe to call from update jobs)
+        // returns the number of nodes released
+        unsigned int release(unsigned int idx);
+
+        /*
+            Statistics
+        */
+
+        // Number of nodes in use (including root)
+        unsigned int noActiveNodes();
+
+        // Number of released nodes waiting to be recycled
+        unsigned int noFreeNodes();
+
+        // Number of nodes the pool can hold without allocating
+        unsigned int capacity();
+
+        // Bytes held by the pool (nodes, their handle lists and the object table)
+        size_t memoryUsage();
+
+        // Reset update counters and timers
+        void resetCounters();
+
+        // Fraction of moved objects that had to be reinserted
+        float reinsertionRate();
+
+    private:
+        friend class node;
+
+        // Objects of ancestors during broad phase (reused between frames)
+        std::vector<ObjectBounds> broadPhaseStack;
+        BoundsBatch::BoxList broadPhaseBoxes;       // boxes of the stack for the batched kernels
+        std::vector<unsigned int> broadPhaseHits;   // stack indices hit by the batched kernels
+
+        // Moved objects of ancestors (the only ones unmoved objects test against)
+        std::vector<ObjectBounds> broadPhaseMoved;
+        BoundsBatch::BoxList broadPhaseMovedBoxes;
+
+        std::vector<node*> blocks;
+        std::vector<unsigned int> freeList;
+
+        // Guards freeList while subtrees are updated in parallel
+        std::mutex releaseMutex;
+
+        // Recursive part of release (releaseMutex held)
+        unsigned int releaseNode(unsigned int idx);
+
+        // Number of slots handed out from blocks
+        unsigned int noSlots;
+    };
+
     class node {
     public:
-        node* parent;
+        NodePool* pool;
 
-        node* children[NO_CHILDREN];
+        unsigned int idx;
+        unsigned int parent;
+
+        unsigned int children[NO_CHILDREN];
 
         unsigned char activeOctants;
 
@@ -47,32 +191,129 @@ namespace Octree {
         bool treeReady = false;
         bool treeBuilt = false;
 
+        // Subtree has objects that moved or were inserted since the last broad phase
+        bool hasMovedObjects = true;
+
         short maxLifespan = 8;
         short currentLifespan = -1;
 
-        std::vector<BoundingRegion> objects;
+        std::vector<unsigned int> objects;  // handles into pool's table
         std::queue<BoundingRegion> queue;
 
         BoundingRegion region;
+        BoundingRegion looseRegion; // region inflated by the pool's looseFactor
 
         node();
 
-        node(BoundingRegion bounds);
+        // Root constructors (allocate the node pool)
+        node(BoundingRegion bounds, float looseFactor = LOOSE_FACTOR);
+
+        node(BoundingRegion bounds, std::vector<BoundingRegion> objectList, float looseFactor = LOOSE_FACTOR);
+
+        // Nodes are referenced by index in the pool, never copied
+        node(const node&) = delete;
+        node& operator=(const node&) = delete;
 
-        node(BoundingRegion bounds, std::vector<BoundingRegion> objectList);
+        ~node();
 
-        void addToPending(RigidBody* instance, trie::Trie<Model*> models);
+        // Get child at octant index (nullptr if not allocated)
+        node* getChild(int i);
+
+        // Get parent node (nullptr if root)
+        node* getParent();
+
+        // Reset values when taken out of the pool
+        void reset(unsigned int idx, unsigned int parent, BoundingRegion bounds);
+
+        // Queue bounds of instance (model is the model of the instance)
+        void addToPending(RigidBody* instance, Model* model);
 
         void build();
 
+        // Bulk build from Morton codes sorted in parallel (0 threads = hardware concurrency)
+        void buildLinear(unsigned int noThreads = 0);
+
         void update();
 
+        // Update root subtrees as parallel jobs (0 threads = hardware concurrency)
+        // objects leaving their subtree are reinserted serially afterwards
+        void updateParallel(unsigned int noThreads = 0);
+
         void processPending();
 
+        // Add region to the table and insert it
         bool insert(BoundingRegion obj);
 
         void destroy();
+
+        /*
+            Queries
+        */
+
+        // Collect instances visible in frustum (marked INSTANCE_VISIBLE, each added once)
+        void cull(Frustum& frustum, std::vector<RigidBody*>& visible);
+
+        // Collect instances of node and its children without testing
+        void collectAll(std::vector<RigidBody*>& visible);
+
+        // Find overlapping pairs into pool's collisionPairs (called by root update)
+        void broadPhase();
+
+        // Structure of the tree and counters of the last update (call on root)
+        Stats collectStats();
+
+        // Find closest instance hit by ray within maxDistance
+        bool castRay(Ray& ray, RayHit& hit, float maxDistance = FLT_MAX);
+
+        // Find closest instance hit between two points
+        bool castSegment(glm::vec3 start, glm::vec3 end, RayHit& hit);
+
+        // Cast many rays, split over threads (0 threads = hardware concurrency)
+        void castRays(std::vector<Ray>& rays, std::vector<RayHit>& hits,
+            float maxDistance = FLT_MAX, unsigned int noThreads = 0);
+
+    private:
+        // Update pass shared by update and updateParallel
+        // - deferred != nullptr: job for subtree at subtreeRoot, objects leaving it are deferred
+        // - noThreads > 1: children are updated as parallel jobs, each splitting again with its share of threads
+        void updateNode(unsigned int subtreeRoot, std::vector<unsigned int>* deferred, unsigned int noThreads);
+
+        // Insert object into the closest enclosing node from this one up
+        // (deferred past subtreeRoot when called from a job)
+        void reinsertObject(unsigned int obj, unsigned int subtreeRoot, std::vector<unsigned int>* deferred);
+
+        // Insert object by handle
+        // without allocation objects that would need a new child stay in the deepest existing node
+        bool insertObject(unsigned int handle, bool allowAllocation = true);
+
+        // Flag node and its ancestors for the broad phase
+        void markMoved();
+
+        // Test objects against each other and ancestors' objects, then recurse
+        void checkCollisions();
+
+        // Test object against every object in nodes it overlaps (loose octree)
+        void findOverlaps(unsigned int handle, ObjectBounds& bounds);
+
+        // Visit children front to back, hit.distance is the current closest hit
+        bool findRayHit(Ray& ray, RayHit& hit);
+
+        // Double the root region towards objects outside of it until they fit, returns true if it grew
+        // (objects outside the root are kept in the root's list)
+        bool growToFit();
+
+        // Move handles of node and its children into handles, children are released
+        void takeObjects(std::vector<unsigned int>& handles);
+
+        // Create child at octant and place objects in it
+        node* createChild(int i, BoundingRegion bounds, std::vector<unsigned int>& objectList);
+
+        // Release child at octant back to the pool, returns the number of nodes released
+        unsigned int releaseChild(int i);
+
+        // Add node and its children to stats
+        void collectStats(Stats& stats, unsigned int depth);
     };
 }
 
-#endif //OCTREE_HPP
\ No newline at end of file
+#endif //OCTREE_HPP
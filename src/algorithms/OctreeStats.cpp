@@ -0,0 +1,107 @@
+#include "OctreeStats.hpp"
+
+/*
+    Timer
+*/
+
+Octree::Timer::Timer()
+    : nanoseconds(0), noCalls(0) {}
+
+void Octree::Timer::reset() {
+    nanoseconds = 0;
+    noCalls = 0;
+}
+
+double Octree::Timer::milliseconds() {
+    return (double)nanoseconds / 1e6;
+}
+
+Octree::ScopedTimer::ScopedTimer(Timer& timer, unsigned int& depth, bool enabled)
+    : timer(timer), depth(depth), timing(enabled && depth == 0) {
+    ++depth;
+    if (timing) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Octree::ScopedTimer::~ScopedTimer() {
+    --depth;
+    if (timing) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        timer.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        ++timer.noCalls;
+    }
+}
+
+/*
+    Stats output
+*/
+
+void Octree::Stats::writeCSVHeader(std::ostream& out) {
+    out << "frame,noNodes,noLeaves,noObjects,maxDepth,averageDepth,averageObjectDepth,memoryUsage,"
+        << "noMovedObjects,noReinsertions,noExpiredNodes,noPairTests,noCollisionPairs,"
+        << "buildTime,updateTime,processPendingTime,insertTime,noInsertCalls";
+
+    for (int i = 0; i < STATS_DEPTH_BUCKETS; ++i) {
+        out << ",depth" << i;
+    }
+    for (int i = 0; i < STATS_OBJECT_BUCKETS; ++i) {
+        out << ",objects" << i;
+    }
+    out << '\n';
+}
+
+void Octree::Stats::writeCSV(std::ostream& out) {
+    out << frame << ',' << noNodes << ',' << noLeaves << ',' << noObjects << ','
+        << maxDepth << ',' << averageDepth << ',' << averageObjectDepth << ',' << memoryUsage << ','
+        << noMovedObjects << ',' << noReinsertions << ',' << noExpiredNodes << ','
+        << noPairTests << ',' << noCollisionPairs << ','
+        << buildTime << ',' << updateTime << ',' << processPendingTime << ','
+        << insertTime << ',' << noInsertCalls;
+
+    for (int i = 0; i < STATS_DEPTH_BUCKETS; ++i) {
+        out << ',' << nodesPerDepth[i];
+    }
+    for (int i = 0; i < STATS_OBJECT_BUCKETS; ++i) {
+        out << ',' << objectsPerNode[i];
+    }
+    out << '\n';
+}
+
+// Write array as JSON list
+static void writeJSONArray(std::ostream& out, unsigned int* values, int size) {
+    out << '[';
+    for (int i = 0; i < size; ++i) {
+        if (i > 0) {
+            out << ',';
+        }
+        out << values[i];
+    }
+    out << ']';
+}
+
+void Octree::Stats::writeJSON(std::ostream& out) {
+    out << "{\"frame\":" << frame
+        << ",\"noNodes\":" << noNodes
+        << ",\"noLeaves\":" << noLeaves
+        << ",\"noObjects\":" << noObjects
+        << ",\"maxDepth\":" << maxDepth
+        << ",\"averageDepth\":" << averageDepth
+        << ",\"averageObjectDepth\":" << averageObjectDepth
+        << ",\"memoryUsage\":" << memoryUsage
+        << ",\"noMovedObjects\":" << noMovedObjects
+        << ",\"noReinsertions\":" << noReinsertions
+        << ",\"noExpiredNodes\":" << noExpiredNodes
+        << ",\"noPairTests\":" << noPairTests
+        << ",\"noCollisionPairs\":" << noCollisionPairs
+        << ",\"buildTime\":" << buildTime
+        << ",\"updateTime\":" << updateTime
+        << ",\"processPendingTime\":" << processPendingTime
+        << ",\"insertTime\":" << insertTime
+        << ",\"noInsertCalls\":" << noInsertCalls
+        << ",\"nodesPerDepth\":";
+    writeJSONArray(out, nodesPerDepth, STATS_DEPTH_BUCKETS);
+    out << ",\"objectsPerNode\":";
+    writeJSONArray(out, objectsPerNode, STATS_OBJECT_BUCKETS);
+    out << "}\n";
+}
@@ -0,0 +1,94 @@
+#ifndef OCTREE_STATS_HPP
+#define OCTREE_STATS_HPP
+
+// Histogram switches (last bucket counts everything above)
+#define STATS_DEPTH_BUCKETS     16  // nodes per depth 0..15+
+#define STATS_OBJECT_BUCKETS    17  // nodes holding 0..16+ objects
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace Octree {
+    /*
+        Wall time accumulated by one kind of octree call
+        - recursive calls on the same thread are only timed once
+        - shared by parallel update jobs
+    */
+    class Timer {
+    public:
+        std::atomic<unsigned long long> nanoseconds;
+        std::atomic<unsigned int> noCalls;
+
+        Timer();
+
+        void reset();
+
+        double milliseconds();
+    };
+
+    // Times the enclosing scope into timer if enabled
+    class ScopedTimer {
+    public:
+        ScopedTimer(Timer& timer, unsigned int& depth, bool enabled);
+
+        ~ScopedTimer();
+
+    private:
+        Timer& timer;
+        unsigned int& depth;
+        bool timing;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /*
+        Snapshot of the tree after an update (see node::collectStats)
+    */
+    struct Stats {
+        unsigned int frame = 0;
+
+        /*
+            Structure
+        */
+
+        unsigned int noNodes = 0;
+        unsigned int noLeaves = 0;
+        unsigned int noObjects = 0;
+        unsigned int maxDepth = 0;
+        float averageDepth = 0.0f;      // of nodes
+        float averageObjectDepth = 0.0f;
+
+        unsigned int nodesPerDepth[STATS_DEPTH_BUCKETS] = {};
+        unsigned int objectsPerNode[STATS_OBJECT_BUCKETS] = {};
+
+        size_t memoryUsage = 0;
+
+        /*
+            Last update
+        */
+
+        unsigned int noMovedObjects = 0;
+        unsigned int noReinsertions = 0;
+        unsigned int noExpiredNodes = 0;    // released after currentLifespan ran out
+        unsigned int noPairTests = 0;
+        unsigned int noCollisionPairs = 0;
+
+        // Wall time in milliseconds (inclusive, update contains the others when called from it)
+        double buildTime = 0.0;
+        double updateTime = 0.0;
+        double processPendingTime = 0.0;
+        double insertTime = 0.0;
+        unsigned int noInsertCalls = 0;
+
+        // Column names matching writeCSV
+        static void writeCSVHeader(std::ostream& out);
+
+        // One line per frame
+        void writeCSV(std::ostream& out);
+
+        // One object per frame
+        void writeJSON(std::ostream& out);
+    };
+}
+
+#endif //OCTREE_STATS_HPP
@@ -0,0 +1,204 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace Parallel {
+    // Number of threads to use (0 = one per hardware thread)
+    inline unsigned int getNoThreads(unsigned int requested = 0) {
+        if (requested > 0) {
+            return requested;
+        }
+        unsigned int hw = std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    /*
+        Persistent worker threads
+        - started once, jobs are handed out in batches
+        - the thread calling run works on its own batch too, so nested runs from jobs can't deadlock
+    */
+    class ThreadPool {
+    public:
+        ThreadPool(unsigned int noWorkers)
+            : stopping(false) {
+            for (unsigned int i = 0; i < noWorkers; ++i) {
+                workers.emplace_back(&ThreadPool::workerLoop, this);
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned int noWorkers() {
+            return workers.size();
+        }
+
+        // Call func(jobIdx) for each job in [0, noJobs), returns once all are done
+        void run(unsigned int noJobs, std::function<void(unsigned int)> func) {
+            if (noJobs == 0) {
+                return;
+            }
+
+            Batch batch = { &func, noJobs, 0, noJobs };
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (noJobs > 1 && workers.size() > 0) {
+                batches.push_back(&batch);
+                wake.notify_all();
+            }
+
+            // Claim jobs of this batch until none are left
+            while (batch.next < batch.noJobs) {
+                unsigned int job = claim(batch);
+                lock.unlock();
+                func(job);
+                lock.lock();
+                --batch.remaining;
+            }
+
+            // Wait for jobs still running on workers
+            done.wait(lock, [&batch]() { return batch.remaining == 0; });
+        }
+
+    private:
+        struct Batch {
+            std::function<void(unsigned int)>* func;
+            unsigned int noJobs;
+            unsigned int next;      // next job to hand out
+            unsigned int remaining; // jobs not finished
+        };
+
+        std::vector<std::thread> workers;
+        std::deque<Batch*> batches; // batches with jobs left to hand out
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        bool stopping;
+
+        // Hand out next job of batch (mutex held), batches leave the queue with their last job
+        unsigned int claim(Batch& batch) {
+            unsigned int job = batch.next++;
+            if (batch.next == batch.noJobs) {
+                auto it = std::find(batches.begin(), batches.end(), &batch);
+                if (it != batches.end()) {
+                    batches.erase(it);
+                }
+            }
+            return job;
+        }
+
+        void workerLoop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                wake.wait(lock, [this]() { return stopping || !batches.empty(); });
+                if (stopping) {
+                    return;
+                }
+
+                Batch& batch = *batches.front();
+                unsigned int job = claim(batch);
+                lock.unlock();
+                (*batch.func)(job);
+                lock.lock();
+
+                if (--batch.remaining == 0) {
+                    done.notify_all();
+                }
+            }
+        }
+    };
+
+    // Pool shared by all parallel loops (one worker per hardware thread besides the caller)
+    inline ThreadPool& getPool() {
+        static ThreadPool pool(getNoThreads() - 1);
+        return pool;
+    }
+
+    // Split [0, size) into one contiguous range per thread
+    // func(begin, end, rangeIdx) is called once for each range, ranges run on the shared pool
+    template<typename F>
+    void forRange(unsigned int size, unsigned int noThreads, F func) {
+        if (noThreads <= 1 || size < noThreads) {
+            // Not worth splitting
+            func(0u, size, 0u);
+            return;
+        }
+
+        unsigned int chunk = (size + noThreads - 1) / noThreads;
+        unsigned int noRanges = (size + chunk - 1) / chunk;
+
+        getPool().run(noRanges, [&](unsigned int t) {
+            unsigned int begin = t * chunk;
+            unsigned int end = std::min(size, begin + chunk);
+            func(begin, end, t);
+        });
+    }
+
+    // Stable LSD radix sort of keys (8 bits per pass), values are moved with their keys
+    inline void radixSort(std::vector<unsigned int>& keys, std::vector<unsigned int>& values,
+        unsigned int keyBits = 32, unsigned int noThreads = 1) {
+        unsigned int size = keys.size();
+        noThreads = std::max(1u, noThreads);
+
+        std::vector<unsigned int> tmpKeys(size), tmpValues(size);
+        // Histogram of digits per thread
+        std::vector<unsigned int> offsets(noThreads * 256);
+
+        for (unsigned int shift = 0; shift < keyBits; shift += 8) {
+            std::fill(offsets.begin(), offsets.end(), 0);
+
+            // Count digits in each thread's range
+            forRange(size, noThreads, [&](unsigned int begin, unsigned int end, unsigned int t) {
+                unsigned int* count = &offsets[t * 256];
+                for (unsigned int i = begin; i < end; ++i) {
+                    ++count[(keys[i] >> shift) & 0xFF];
+                }
+            });
+
+            // Exclusive prefix sum (digit major, thread minor keeps the sort stable)
+            unsigned int sum = 0;
+            for (unsigned int d = 0; d < 256; ++d) {
+                for (unsigned int t = 0; t < noThreads; ++t) {
+                    unsigned int count = offsets[t * 256 + d];
+                    offsets[t * 256 + d] = sum;
+                    sum += count;
+                }
+            }
+
+            // Scatter
+            forRange(size, noThreads, [&](unsigned int begin, unsigned int end, unsigned int t) {
+                unsigned int* offset = &offsets[t * 256];
+                for (unsigned int i = begin; i < end; ++i) {
+                    unsigned int dst = offset[(keys[i] >> shift) & 0xFF]++;
+                    tmpKeys[dst] = keys[i];
+                    tmpValues[dst] = values[i];
+                }
+            });
+
+            keys.swap(tmpKeys);
+            values.swap(tmpValues);
+        }
+    }
+}
+
+#endif //PARALLEL_HPP
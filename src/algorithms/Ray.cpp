@@ -0,0 +1,23 @@
+#include "Ray.hpp"
+
+/*
+    Constructors
+*/
+
+Ray::Ray()
+    : origin(0.0f), direction(0.0f, 0.0f, -1.0f), invDirection(1.0f / direction) {}
+
+Ray::Ray(glm::vec3 origin, glm::vec3 direction)
+    : origin(origin), direction(glm::normalize(direction)) {
+    invDirection = 1.0f / this->direction;
+}
+
+/*
+    Testing methods
+*/
+
+bool Ray::intersectsWith(BoundingRegion& br, float& entry, float maxDistance) {
+    return (br.type == BoundTypes::AABB)
+        ? intersectsWith(br.box(), entry, maxDistance)
+        : intersectsWith(br.sphere(), entry, maxDistance);
+}
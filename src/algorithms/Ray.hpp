@@ -0,0 +1,91 @@
+#ifndef RAY_HPP
+#define RAY_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+// Closest instance hit by a ray
+struct RayHit {
+    RigidBody* instance;
+    float distance;
+};
+
+class Ray {
+public:
+    glm::vec3 origin;
+    glm::vec3 direction;    // normalized
+    glm::vec3 invDirection; // 1 / direction (slab tests)
+
+    /*
+        Constructors
+    */
+
+    Ray();
+
+    Ray(glm::vec3 origin, glm::vec3 direction);
+
+    /*
+        Testing methods
+    */
+
+    // Determine if ray hits region before maxDistance
+    // entry = distance where ray enters region (0 if origin is inside)
+    bool intersectsWith(BoundingRegion& br, float& entry, float maxDistance);
+
+    // Typed tests are inline, queries run them on every object of the nodes they visit
+    bool intersectsWith(const AABB& box, float& entry, float maxDistance) {
+        // Slab test - distances to the planes of each axis
+        float tEnter = -INFINITY;
+        float tExit = INFINITY;
+
+        for (int i = 0; i < 3; ++i) {
+            if (direction[i] == 0.0f) {
+                // Parallel to the slab, inside it along the whole ray or never
+                // (0 * inf would be NaN when the origin lies on a plane)
+                if (origin[i] < box.min[i] || origin[i] > box.max[i]) {
+                    return false;
+                }
+                continue;
+            }
+
+            float t1 = (box.min[i] - origin[i]) * invDirection[i];
+            float t2 = (box.max[i] - origin[i]) * invDirection[i];
+
+            tEnter = std::max(tEnter, std::min(t1, t2));
+            tExit = std::min(tExit, std::max(t1, t2));
+        }
+
+        if (tExit < 0.0f || tEnter > tExit || tEnter > maxDistance) {
+            return false;
+        }
+
+        entry = std::max(tEnter, 0.0f);
+        return true;
+    }
+
+    bool intersectsWith(const BoundingSphere& sphere, float& entry, float maxDistance) {
+        // Solve |origin + t * direction - center| = radius
+        glm::vec3 oc = origin - sphere.center;
+        float b = glm::dot(oc, direction);
+        float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+
+        if (c > 0.0f && b > 0.0f) {
+            // Outside and pointing away
+            return false;
+        }
+
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f) {
+            return false;
+        }
+
+        entry = std::max(-b - sqrtf(discriminant), 0.0f);
+        return entry <= maxDistance;
+    }
+};
+
+#endif //RAY_HPP
@@ -0,0 +1,148 @@
+#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <cstddef>
+#include <vector>
+
+#define NULL_SLOT 0xFFFFFFFF    // Index of a handle to nothing
+
+namespace slotmap {
+    // Handle to an element (index of its slot + generation of the slot when it was issued)
+    struct Handle {
+        unsigned int index;
+        unsigned int generation;
+
+        bool operator==(const Handle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(const Handle& other) const {
+            return !(*this == other);
+        }
+    };
+
+    const Handle nullHandle = { NULL_SLOT, 0 };
+
+    /*
+        Generational slot map
+        - elements are stored densely (iterate values() directly)
+        - handles stay valid while their element lives, O(1) lookup through the slot
+        - erase swaps the last element into the hole (O(1), order is not kept)
+        - erasing bumps the slot generation, so stale handles are detected
+    */
+    template <typename T>
+    class SlotMap {
+    public:
+        /*
+            modifiers
+        */
+
+        // add element, returns its handle
+        Handle insert(T value) {
+            unsigned int index;
+
+            if (freeSlots.size() > 0) {
+                // Recycle slot (generation was bumped on erase)
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else {
+                index = slots.size();
+                slots.push_back({ 0, 0 });
+            }
+
+            slots[index].denseIdx = dense.size();
+            dense.push_back(value);
+            denseToSlot.push_back(index);
+
+            return { index, slots[index].generation };
+        }
+
+        // remove element, returns false for stale handles
+        bool erase(Handle handle) {
+            if (!contains(handle)) {
+                return false;
+            }
+
+            Slot& slot = slots[handle.index];
+            unsigned int last = dense.size() - 1;
+
+            if (slot.denseIdx != last) {
+                // Move last element into the hole
+                dense[slot.denseIdx] = dense[last];
+                denseToSlot[slot.denseIdx] = denseToSlot[last];
+                slots[denseToSlot[last]].denseIdx = slot.denseIdx;
+            }
+
+            dense.pop_back();
+            denseToSlot.pop_back();
+
+            ++slot.generation;
+            freeSlots.push_back(handle.index);
+
+            return true;
+        }
+
+        // remove all elements (outstanding handles become stale)
+        void clear() {
+            for (unsigned int i = 0; i < dense.size(); ++i) {
+                unsigned int index = denseToSlot[i];
+                ++slots[index].generation;
+                freeSlots.push_back(index);
+            }
+
+            dense.clear();
+            denseToSlot.clear();
+        }
+
+        /*
+            accessors
+        */
+
+        // determine if handle refers to a live element
+        bool contains(Handle handle) {
+            return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+        }
+
+        // element of handle (nullptr if stale)
+        T* get(Handle handle) {
+            return contains(handle) ? &dense[slots[handle.index].denseIdx] : nullptr;
+        }
+
+        // handle of element at position in values()
+        Handle getHandle(unsigned int denseIdx) {
+            unsigned int index = denseToSlot[denseIdx];
+            return { index, slots[index].generation };
+        }
+
+        // live elements
+        std::vector<T>& values() {
+            return dense;
+        }
+
+        unsigned int size() {
+            return dense.size();
+        }
+
+        // bytes held by the map
+        size_t memoryUsage() {
+            return slots.capacity() * sizeof(Slot) +
+                dense.capacity() * sizeof(T) +
+                (denseToSlot.capacity() + freeSlots.capacity()) * sizeof(unsigned int);
+        }
+
+    private:
+        struct Slot {
+            unsigned int denseIdx;      // position of the element in dense
+            unsigned int generation;    // bumped every time the element is erased
+        };
+
+        std::vector<Slot> slots;
+        std::vector<unsigned int> freeSlots;
+
+        std::vector<T> dense;
+        std::vector<unsigned int> denseToSlot;
+    };
+}
+
+#endif //SLOT_MAP_HPP
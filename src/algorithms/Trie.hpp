@@ -4,6 +4,12 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstring>
+
+#define TRIE_NO_NODE_TYPES 4
+#define TRIE_NO_INDICES 256		// characters are looked up by their byte value
+#define TRIE_EMPTY_SLOT 0xFF	// unused entry of node48::slots
+#define TRIE_INVALID_CHAR -1	// character not in the charset
 
 namespace trie {
 	struct Range {
@@ -29,32 +35,80 @@ namespace trie {
 	const charset alpha_numeric = { { '0', '9' }, { 'A', 'Z' }, { 'a', 'z' } };
 
 	/*
-		trie node structure
+		adaptive node types
+		- nodes start with room for 4 children and grow to 16, 48 and 256
+		- node4 and node16 keep sorted keys next to their children
+		- node48 maps every index to one of 48 child slots
+		- node256 is indexed directly
+	*/
+	enum class NodeType : unsigned char {
+		NODE4 = 0,
+		NODE16 = 1,
+		NODE48 = 2,
+		NODE256 = 3
+	};
+
+	/*
+		trie node structure (header shared by all node types)
 	*/
 	template <typename T>
 	struct node {
+		NodeType type;
 		bool exists;				// if data exists
+		unsigned short noChildren;	// number of children
 		T data;						// data
-		struct node<T>** children;	// array of children
 
-		// traverse into this node and its children
-		// send data to callback if data exists
-		void traverse(void(*itemViewer)(T data), unsigned int noChildren) {
-			if (exists) {
-				itemViewer(data);
-			}
+		node(NodeType type)
+			: type(type), exists(false), noChildren(0), data() {}
+	};
 
-			// iterate through children
-			if (children) {
-				for (int i = 0; i < noChildren; i++) {
-					if (children[i]) {
-						children[i]->traverse(itemViewer, noChildren);
-					}
-				}
-			}
+	// node with sorted keys (node4 and node16)
+	template <typename T, unsigned int capacity>
+	struct node_list : node<T> {
+		unsigned char keys[capacity];
+		node<T>* children[capacity];
+
+		node_list()
+			: node<T>(capacity == 4 ? NodeType::NODE4 : NodeType::NODE16) {}
+	};
+
+	template <typename T>
+	using node4 = node_list<T, 4>;
+
+	template <typename T>
+	using node16 = node_list<T, 16>;
+
+	template <typename T>
+	struct node48 : node<T> {
+		unsigned char slots[TRIE_NO_INDICES];	// index -> child slot
+		node<T>* children[48];
+
+		node48()
+			: node<T>(NodeType::NODE48) {
+			memset(slots, TRIE_EMPTY_SLOT, sizeof(slots));
+			memset(children, 0, sizeof(children));
 		}
 	};
 
+	template <typename T>
+	struct node256 : node<T> {
+		node<T>* children[TRIE_NO_INDICES];
+
+		node256()
+			: node<T>(NodeType::NODE256) {
+			memset(children, 0, sizeof(children));
+		}
+	};
+
+	/*
+		memory report
+	*/
+	struct MemoryReport {
+		unsigned int noKeys;
+		unsigned int noNodes[TRIE_NO_NODE_TYPES];	// by NodeType
+		size_t bytes;								// nodes and lookup table
+	};
+
 	/*
 		trie class
 	*/
@@ -65,19 +119,44 @@ namespace trie {
 			constructor
 		*/
 		Trie(charset chars = alpha_numeric)
-			: chars(chars), noChars(0), root(nullptr) {
-			// set number of chars
+			: chars(chars), noChars(0), noKeys(0), root(nullptr) {
+			// precompute character -> index
+			for (int i = 0; i < TRIE_NO_INDICES; i++) {
+				lookup[i] = TRIE_INVALID_CHAR;
+			}
 			for (Range r : chars) {
-				noChars += r.calculateRange();
+				for (int c = r.lower; c <= r.upper; c++) {
+					lookup[(unsigned char)c] = noChars++;
+				}
+			}
+
+			for (int i = 0; i < TRIE_NO_NODE_TYPES; i++) {
+				noNodes[i] = 0;
 			}
 
 			// initialize root memory
-			root = new node<T>;
-			root->exists = false;
-			root->children = new node<T> * [noChars];
-			for (int i = 0; i < noChars; i++) {
-				root->children[i] = NULL;
+			root = newNode<node4<T>>();
+		}
+
+		// nodes are owned, only moves are allowed (moved-from trie only supports cleanup and destruction)
+		Trie(const Trie&) = delete;
+		Trie& operator=(const Trie&) = delete;
+
+		Trie(Trie&& other)
+			: root(nullptr) {
+			take(other);
+		}
+
+		Trie& operator=(Trie&& other) {
+			if (this != &other) {
+				unloadNode(root);
+				take(other);
 			}
+			return *this;
+		}
+
+		~Trie() {
+			unloadNode(root);
 		}
 
 		/*
@@ -86,54 +165,88 @@ namespace trie {
 
 		// insertion (can also use to change data)
 		bool insert(std::string key, T element) {
-			int idx;
-			node<T>* current = root;
-
+			// validate first so no empty branches are left behind
 			for (char c : key) {
-				idx = getIdx(c);
-				if (idx == -1) {
+				if (getIdx(c) == TRIE_INVALID_CHAR) {
 					return false;
 				}
-				if (!current->children[idx]) {
+			}
+
+			node<T>** current = &root;
+
+			for (char c : key) {
+				unsigned char idx = (unsigned char)getIdx(c);
+				node<T>** child = findChild(*current, idx);
+				if (!child) {
 					// child doesn't exist yet
-					current->children[idx] = new node<T>;
-					current->children[idx]->exists = false;
-					current->children[idx]->children = new node<T> * [noChars];
-					for (int i = 0; i < noChars; i++) {
-						current->children[idx]->children[i] = NULL;
-					}
+					addChild(current, idx, newNode<node4<T>>());
+					child = findChild(*current, idx);
 				}
-				current = current->children[idx];
+				current = child;
 			}
 
 			// set data
-			current->data = element;
-			current->exists = true;
+			if (!(*current)->exists) {
+				noKeys++;
+			}
+			(*current)->data = element;
+			(*current)->exists = true;
 
 			return true;
 		}
 
-		// deletion method
+		// deletion method (releases nodes left without data or children)
 		bool erase(std::string key) {
 			if (!root) {
 				return false;
 			}
 
-			// pass lambda function that sets target element->exists to false
-			return findKey<bool>(key, [](node<T>* element) -> bool {
-				if (!element) {
-					// element is nullptr
+			// slots of nodes along the key
+			std::vector<node<T>**> path = { &root };
+			std::vector<unsigned char> indices;
+
+			for (char c : key) {
+				int idx = getIdx(c);
+				if (idx == TRIE_INVALID_CHAR) {
 					return false;
 				}
 
-				element->exists = false;
-				return true;
-			});
+				node<T>** child = findChild(*path.back(), (unsigned char)idx);
+				if (!child) {
+					return false;
+				}
+				path.push_back(child);
+				indices.push_back((unsigned char)idx);
+			}
+
+			node<T>* target = *path.back();
+			if (!target->exists) {
+				return false;
+			}
+
+			target->exists = false;
+			target->data = T();
+			noKeys--;
+
+			// remove empty nodes bottom up (root stays)
+			for (int i = (int)indices.size() - 1; i >= 0; i--) {
+				node<T>* current = *path[i + 1];
+				if (current->exists || current->noChildren > 0) {
+					break;
+				}
+
+				freeNode(current);
+				removeChild(path[i], indices[i]);
+			}
+
+			return true;
 		}
 
-		// release root note
+		// release all nodes (trie stays usable)
 		void cleanup() {
 			unloadNode(root);
+			noKeys = 0;
+			root = newNode<node4<T>>();
 		}
 
 		/*
@@ -166,22 +279,69 @@ namespace trie {
 			});
 		}
 
-		// traverse through all keys
+		// traverse through all keys (in charset order)
 		void traverse(void(*itemViewer)(T data)) {
 			if (root) {
-				root->traverse(itemViewer, noChars);
+				traverseNode(root, itemViewer);
 			}
 		}
 
+		// number of keys with data
+		unsigned int size() {
+			return noKeys;
+		}
+
+		// memory held by the trie
+		MemoryReport memoryReport() {
+			MemoryReport ret;
+			ret.noKeys = noKeys;
+			ret.bytes = sizeof(lookup);
+			for (int i = 0; i < TRIE_NO_NODE_TYPES; i++) {
+				ret.noNodes[i] = noNodes[i];
+			}
+
+			ret.bytes += noNodes[(int)NodeType::NODE4] * sizeof(node4<T>);
+			ret.bytes += noNodes[(int)NodeType::NODE16] * sizeof(node16<T>);
+			ret.bytes += noNodes[(int)NodeType::NODE48] * sizeof(node48<T>);
+			ret.bytes += noNodes[(int)NodeType::NODE256] * sizeof(node256<T>);
+
+			return ret;
+		}
+
 	private:
 		// character set
 		charset chars;
 		// length of set
 		unsigned int noChars;
+		// index of each character (TRIE_INVALID_CHAR if not in set)
+		short lookup[TRIE_NO_INDICES];
+
+		// counters for the memory report
+		unsigned int noKeys;
+		unsigned int noNodes[TRIE_NO_NODE_TYPES];
 
 		// root node
 		node<T>* root;
 
+		// move state of other into this trie (current nodes are already released)
+		void take(Trie& other) {
+			chars = other.chars;
+			noChars = other.noChars;
+			for (int i = 0; i < TRIE_NO_INDICES; i++) {
+				lookup[i] = other.lookup[i];
+			}
+
+			noKeys = other.noKeys;
+			for (int i = 0; i < TRIE_NO_NODE_TYPES; i++) {
+				noNodes[i] = other.noNodes[i];
+				other.noNodes[i] = 0;
+			}
+
+			root = other.root;
+			other.root = nullptr;
+			other.noKeys = 0;
+		}
+
 		// find element at key and process it
 		template <typename V>
 		V findKey(std::string key, V(*process)(node<T>* element)) {
@@ -191,38 +351,268 @@ namespace trie {
 			for (char c : key) {
 				idx = getIdx(c);
 
-				if (idx == -1) {
+				if (idx == TRIE_INVALID_CHAR) {
 					// leave to parameter function to deal with nullptr
 					return process(nullptr);
 				}
 
 				// update current
-				current = current->children[idx];
-				if (!current) {
+				node<T>** child = findChild(current, (unsigned char)idx);
+				if (!child) {
 					// leave to parameter function to deal with nullptr
 					return process(nullptr);
 				}
+				current = *child;
 			}
 			return process(current);
 		}
 
 		// get index at specific character in character set
-		// return -1 if not found
+		// return TRIE_INVALID_CHAR if not found
 		int getIdx(char c) {
-			int ret = 0;
+			return lookup[(unsigned char)c];
+		}
 
-			for (Range r : chars) {
-				if (r.contains((int)c)) {
-					ret += (int)c - r.lower;
-					break;
+		/*
+			node management
+		*/
+
+		template <typename N>
+		N* newNode() {
+			N* ret = new N;
+			noNodes[(int)ret->type]++;
+			return ret;
+		}
+
+		void freeNode(node<T>* n) {
+			noNodes[(int)n->type]--;
+
+			switch (n->type) {
+			case NodeType::NODE4: delete (node4<T>*)n; break;
+			case NodeType::NODE16: delete (node16<T>*)n; break;
+			case NodeType::NODE48: delete (node48<T>*)n; break;
+			case NodeType::NODE256: delete (node256<T>*)n; break;
+			}
+		}
+
+		// slot holding child at index (nullptr if there is none)
+		node<T>** findChild(node<T>* n, unsigned char idx) {
+			switch (n->type) {
+			case NodeType::NODE4: return findInList((node4<T>*)n, idx);
+			case NodeType::NODE16: return findInList((node16<T>*)n, idx);
+			case NodeType::NODE48: {
+				node48<T>* n48 = (node48<T>*)n;
+				unsigned char slot = n48->slots[idx];
+				return slot == TRIE_EMPTY_SLOT ? nullptr : &n48->children[slot];
+			}
+			case NodeType::NODE256: {
+				node256<T>* n256 = (node256<T>*)n;
+				return n256->children[idx] ? &n256->children[idx] : nullptr;
+			}
+			}
+			return nullptr;
+		}
+
+		template <unsigned int capacity>
+		node<T>** findInList(node_list<T, capacity>* n, unsigned char idx) {
+			for (unsigned int i = 0; i < n->noChildren; i++) {
+				if (n->keys[i] == idx) {
+					return &n->children[i];
+				}
+			}
+			return nullptr;
+		}
+
+		// copy header into a node of another type
+		template <typename N>
+		N* copyHeader(node<T>* n) {
+			N* ret = newNode<N>();
+			ret->exists = n->exists;
+			ret->data = n->data;
+			return ret;
+		}
+
+		// call f(idx, child) for each child in index order
+		template <typename F>
+		void forEachChild(node<T>* n, F f) {
+			switch (n->type) {
+			case NodeType::NODE4: {
+				node4<T>* list = (node4<T>*)n;
+				for (unsigned int i = 0; i < list->noChildren; i++) {
+					f(list->keys[i], list->children[i]);
+				}
+				break;
+			}
+			case NodeType::NODE16: {
+				node16<T>* list = (node16<T>*)n;
+				for (unsigned int i = 0; i < list->noChildren; i++) {
+					f(list->keys[i], list->children[i]);
+				}
+				break;
+			}
+			case NodeType::NODE48: {
+				node48<T>* n48 = (node48<T>*)n;
+				for (int i = 0; i < TRIE_NO_INDICES; i++) {
+					if (n48->slots[i] != TRIE_EMPTY_SLOT) {
+						f((unsigned char)i, n48->children[n48->slots[i]]);
+					}
+				}
+				break;
+			}
+			case NodeType::NODE256: {
+				node256<T>* n256 = (node256<T>*)n;
+				for (int i = 0; i < TRIE_NO_INDICES; i++) {
+					if (n256->children[i]) {
+						f((unsigned char)i, n256->children[i]);
+					}
+				}
+				break;
+			}
+			}
+		}
+
+		// move header and children of n to a node of type N, update slot holding n
+		template <typename N>
+		void resize(node<T>** slot) {
+			node<T>* n = *slot;
+			N* ret = copyHeader<N>(n);
+
+			forEachChild(n, [this, ret](unsigned char idx, node<T>* child) {
+				placeChild(ret, idx, child);
+			});
+
+			freeNode(n);
+			*slot = ret;
+		}
+
+		// add child at index (grows the node in slot when it is full)
+		void addChild(node<T>** slot, unsigned char idx, node<T>* child) {
+			node<T>* n = *slot;
+
+			switch (n->type) {
+			case NodeType::NODE4:
+				if (n->noChildren == 4) {
+					resize<node16<T>>(slot);
+				}
+				break;
+			case NodeType::NODE16:
+				if (n->noChildren == 16) {
+					resize<node48<T>>(slot);
+				}
+				break;
+			case NodeType::NODE48:
+				if (n->noChildren == 48) {
+					resize<node256<T>>(slot);
+				}
+				break;
+			default:
+				break;
+			}
+
+			placeChild(*slot, idx, child);
+		}
+
+		// add child to node with room for it
+		void placeChild(node<T>* n, unsigned char idx, node<T>* child) {
+			switch (n->type) {
+			case NodeType::NODE4: insertInList((node4<T>*)n, idx, child); break;
+			case NodeType::NODE16: insertInList((node16<T>*)n, idx, child); break;
+			case NodeType::NODE48: {
+				node48<T>* n48 = (node48<T>*)n;
+				unsigned char i = 0;
+				while (n48->children[i]) {
+					i++;
+				}
+				n48->children[i] = child;
+				n48->slots[idx] = i;
+				break;
+			}
+			case NodeType::NODE256:
+				((node256<T>*)n)->children[idx] = child;
+				break;
+			}
+
+			n->noChildren++;
+		}
+
+		template <unsigned int capacity>
+		void insertInList(node_list<T, capacity>* n, unsigned char idx, node<T>* child) {
+			// keep keys sorted
+			unsigned int i = n->noChildren;
+			while (i > 0 && n->keys[i - 1] > idx) {
+				n->keys[i] = n->keys[i - 1];
+				n->children[i] = n->children[i - 1];
+				i--;
+			}
+			n->keys[i] = idx;
+			n->children[i] = child;
+		}
+
+		// remove child at index (shrinks the node in slot when it gets sparse)
+		void removeChild(node<T>** slot, unsigned char idx) {
+			node<T>* n = *slot;
+
+			switch (n->type) {
+			case NodeType::NODE4: removeFromList((node4<T>*)n, idx); break;
+			case NodeType::NODE16: removeFromList((node16<T>*)n, idx); break;
+			case NodeType::NODE48: {
+				node48<T>* n48 = (node48<T>*)n;
+				n48->children[n48->slots[idx]] = nullptr;
+				n48->slots[idx] = TRIE_EMPTY_SLOT;
+				break;
+			}
+			case NodeType::NODE256:
+				((node256<T>*)n)->children[idx] = nullptr;
+				break;
+			}
+
+			n->noChildren--;
+
+			// shrink once the smaller type would be half full
+			// (nodes at a boundary don't resize back and forth)
+			switch (n->type) {
+			case NodeType::NODE16:
+				if (n->noChildren <= 4 / 2) {
+					resize<node4<T>>(slot);
+				}
+				break;
+			case NodeType::NODE48:
+				if (n->noChildren <= 16 / 2) {
+					resize<node16<T>>(slot);
 				}
-				else {
-					ret += r.calculateRange();
+				break;
+			case NodeType::NODE256:
+				if (n->noChildren <= 48 / 2) {
+					resize<node48<T>>(slot);
 				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		template <unsigned int capacity>
+		void removeFromList(node_list<T, capacity>* n, unsigned char idx) {
+			unsigned int i = 0;
+			while (n->keys[i] != idx) {
+				i++;
+			}
+			for (; i + 1 < n->noChildren; i++) {
+				n->keys[i] = n->keys[i + 1];
+				n->children[i] = n->children[i + 1];
+			}
+		}
+
+		// traverse into this node and its children
+		// send data to callback if data exists
+		void traverseNode(node<T>* n, void(*itemViewer)(T data)) {
+			if (n->exists) {
+				itemViewer(n->data);
 			}
 
-			// went through all ranges and found nothing, return -1
-			return ret == noChars ? -1 : ret;
+			forEachChild(n, [this, itemViewer](unsigned char, node<T>* child) {
+				traverseNode(child, itemViewer);
+			});
 		}
 
 		// unload node and its children
@@ -231,16 +621,13 @@ namespace trie {
 				return;
 			}
 
-			for (int i = 0; i < noChars; i++) {
-				if (top->children[i]) {
-					// child exists, deallocate it
-					unloadNode(top->children[i]);
-				}
-			}
+			forEachChild(top, [this](unsigned char, node<T>* child) {
+				unloadNode(child);
+			});
 
-			top = nullptr;
+			freeNode(top);
 		}
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,748 @@
+/*
+    engine_bench
+    - headless CPU benchmarks for user_algorithms and physics (no window or GL context)
+    - reports ns/op, throughput and peak memory as JSON
+
+    usage: engine_bench [--min N] [--max N] [--filter text] [--out file.json]
+    - with --out the file is rewritten after every measurement, so an interrupted run keeps what it measured
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../algorithms/Bounds.hpp"
+#include "../algorithms/BoundsBatch.hpp"
+#include "../algorithms/Octree.hpp"
+#include "../algorithms/Parallel.hpp"
+#include "../algorithms/SlotMap.hpp"
+#include "../algorithms/Trie.hpp"
+#include "../physics/InstanceStore.hpp"
+#include "../physics/Integrator.hpp"
+#include "../physics/RigidBody.hpp"
+
+#define BENCH_MIN_SIZE      1000
+#define BENCH_MAX_SIZE      1000000
+#define BENCH_MIN_OPS       1000000     // cheap kernels are repeated until this many ops ran
+#define BENCH_UPDATE_FRAMES 10          // max octree updates per measurement
+#define BENCH_UPDATE_OPS    1000000     // frames are cut down to about this many objects updated
+#define BENCH_MIN_THREADS   2           // threads of parallel cases (at least, so the split runs on one core too)
+#define BENCH_MAX_RAYS      10000       // rays cast per measurement
+#define BENCH_OBJECT_RADIUS 0.5f
+#define BENCH_DT            0.016f
+
+/*
+    Measurement
+*/
+
+struct Result {
+    std::string name;
+    unsigned int size;
+    unsigned long long noOps;
+    double seconds;
+    size_t peakMemory;  // process high water mark in bytes
+};
+
+// Keeps results of benchmarked calls alive
+static volatile unsigned long long sink = 0;
+
+// Peak resident memory of the process in bytes
+static size_t getPeakMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;         // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // kilobytes
+#endif
+#endif
+}
+
+class Bench {
+public:
+    unsigned int minSize;
+    unsigned int maxSize;
+    std::string filter;
+    std::string outPath;    // empty = JSON to stdout at the end
+    std::vector<Result> results;
+    bool failed;            // a check between measurements failed (exit code 1)
+
+    Bench()
+        : minSize(BENCH_MIN_SIZE), maxSize(BENCH_MAX_SIZE), failed(false) {}
+
+    // Sizes from minSize to maxSize in powers of 10
+    std::vector<unsigned int> sizes() {
+        std::vector<unsigned int> ret;
+        for (unsigned long long size = minSize; size <= maxSize; size *= 10) {
+            ret.push_back((unsigned int)size);
+        }
+        return ret;
+    }
+
+    bool enabled(std::string name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Time run() which performs noOps operations on size elements
+    // setup() is called before each repetition and is not timed
+    void measure(std::string name, unsigned int size, unsigned long long noOps,
+        std::function<void()> run, std::function<void()> setup = nullptr, unsigned int noRepeats = 1) {
+        double seconds = 0.0;
+
+        for (unsigned int i = 0; i < noRepeats; ++i) {
+            if (setup) {
+                setup();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            run();
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        Result result = { name, size, noOps * noRepeats, seconds, getPeakMemory() };
+        results.push_back(result);
+
+        std::cerr << name << " n=" << size << ": "
+            << nsPerOp(result) << " ns/op" << std::endl;
+
+        if (!outPath.empty()) {
+            writeFile();
+        }
+    }
+
+    // Repetitions for a kernel of size ops to reach BENCH_MIN_OPS
+    static unsigned int repeatsFor(unsigned int size) {
+        return size >= BENCH_MIN_OPS ? 1 : BENCH_MIN_OPS / size;
+    }
+
+    // Octree updates of size objects per measurement (large trees run fewer frames so they finish)
+    static unsigned int updateFramesFor(unsigned int size) {
+        return std::max(1u, std::min((unsigned int)BENCH_UPDATE_FRAMES, BENCH_UPDATE_OPS / size));
+    }
+
+    static double nsPerOp(Result& result) {
+        return result.noOps == 0 ? 0.0 : result.seconds * 1e9 / result.noOps;
+    }
+
+    void writeJSON(std::ostream& out) {
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            Result& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\""
+                << ", \"size\": " << r.size
+                << ", \"ops\": " << r.noOps
+                << ", \"seconds\": " << r.seconds
+                << ", \"nsPerOp\": " << nsPerOp(r)
+                << ", \"opsPerSecond\": " << (r.seconds > 0.0 ? r.noOps / r.seconds : 0.0)
+                << ", \"peakMemory\": " << r.peakMemory
+                << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    // Write all results so far to outPath, returns false if it can't be opened
+    bool writeFile() {
+        std::ofstream out(outPath);
+        if (!out) {
+            return false;
+        }
+        writeJSON(out);
+        return true;
+    }
+};
+
+/*
+    Workloads
+*/
+
+// Half extent of a world holding size objects at constant density
+static float worldExtent(unsigned int size) {
+    return 2.0f * std::cbrt((float)size);
+}
+
+static std::vector<glm::vec3> randomPoints(unsigned int size, float extent, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-extent, extent);
+
+    std::vector<glm::vec3> ret(size);
+    for (glm::vec3& pt : ret) {
+        pt = glm::vec3(dist(rng), dist(rng), dist(rng));
+    }
+    return ret;
+}
+
+// Fill store with size instances (call InstanceStore::clear when done)
+static void createInstances(InstanceStore& instances, unsigned int size, unsigned int seed) {
+    std::vector<glm::vec3> points = randomPoints(size, worldExtent(size), seed);
+
+    for (glm::vec3& pt : points) {
+        instances.add(interned::hash("bench"), glm::vec3(1.0f), 1.0f, pt);
+    }
+}
+
+// Sphere regions attached to instances (like model bounds in the scene)
+static std::vector<BoundingRegion> createRegions(InstanceStore& instances) {
+    std::vector<BoundingRegion> ret;
+    ret.reserve(instances.noInstances());
+    for (RigidBody* rb : instances.bodies) {
+        BoundingRegion br(glm::vec3(0.0f), BENCH_OBJECT_RADIUS);
+        br.instance = rb;
+        br.transform();
+        ret.push_back(br);
+    }
+    return ret;
+}
+
+// Sequential ids like Scene::generateId
+static std::vector<std::string> createKeys(unsigned int size) {
+    std::vector<std::string> ret;
+    ret.reserve(size);
+
+    std::string id = "aaaaaaa";
+    for (unsigned int i = 0; i < size; ++i) {
+        for (int c = id.length() - 1; c >= 0; --c) {
+            if (id[c] != 'z') {
+                ++id[c];
+                break;
+            }
+            id[c] = 'a';
+        }
+        ret.push_back(id);
+    }
+    return ret;
+}
+
+static void traverseItem(int data) {
+    sink += data;
+}
+
+/*
+    Benchmarks
+*/
+
+static void benchBounds(Bench& bench, unsigned int size) {
+    std::vector<glm::vec3> points = randomPoints(size + 1, worldExtent(size), 1);
+    std::vector<BoundingRegion> boxes, spheres;
+    for (glm::vec3& pt : points) {
+        boxes.push_back(BoundingRegion(pt - glm::vec3(1.0f), pt + glm::vec3(1.0f)));
+        spheres.push_back(BoundingRegion(pt, 1.0f));
+    }
+    unsigned int noRepeats = Bench::repeatsFor(size);
+
+    if (bench.enabled("bounds.containsRegion")) {
+        bench.measure("bounds.containsRegion", size, size, [&]() {
+            unsigned long long count = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                count += boxes[i].containsRegion(boxes[i + 1]);
+            }
+            sink += count;
+        }, nullptr, noRepeats);
+    }
+
+    if (bench.enabled("bounds.intersectsWith.aabb")) {
+        bench.measure("bounds.intersectsWith.aabb", size, size, [&]() {
+            unsigned long long count = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                count += boxes[i].intersectsWith(boxes[i + 1]);
+            }
+            sink += count;
+        }, nullptr, noRepeats);
+    }
+
+    if (bench.enabled("bounds.intersectsWith.sphere")) {
+        bench.measure("bounds.intersectsWith.sphere", size, size, [&]() {
+            unsigned long long count = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                count += spheres[i].intersectsWith(spheres[i + 1]);
+            }
+            sink += count;
+        }, nullptr, noRepeats);
+    }
+
+    // One region against all regions with the batched kernels at each level
+    BoundsBatch::BoxList boxList;
+    std::vector<float> x, y, z, radius;
+    for (unsigned int i = 0; i < size; ++i) {
+        boxList.push_back(boxes[i].min, boxes[i].max);
+        x.push_back(spheres[i].center.x);
+        y.push_back(spheres[i].center.y);
+        z.push_back(spheres[i].center.z);
+        radius.push_back(spheres[i].radius);
+    }
+    BoundsBatch::SphereArrays sphereArrays = { x.data(), y.data(), z.data(), radius.data() };
+    std::vector<unsigned int> hits(size);
+
+    const char* levelNames[] = { "scalar", "sse", "avx2" };
+    BoundsBatch::SimdLevel supported = BoundsBatch::getSupportedLevel();
+    for (int level = 0; level <= (int)supported; ++level) {
+        BoundsBatch::setLevel((BoundsBatch::SimdLevel)level);
+
+        std::string name = std::string("bounds.batch.aabb.") + levelNames[level];
+        if (bench.enabled(name)) {
+            bench.measure(name, size, size, [&]() {
+                sink += BoundsBatch::intersectBoxes(boxes[size].min, boxes[size].max, boxList.arrays(),
+                    0, size, hits.data());
+            }, nullptr, noRepeats);
+        }
+
+        name = std::string("bounds.batch.sphere.") + levelNames[level];
+        if (bench.enabled(name)) {
+            bench.measure(name, size, size, [&]() {
+                sink += BoundsBatch::intersectSpheres(spheres[size].center, spheres[size].radius, sphereArrays,
+                    0, size, hits.data());
+            }, nullptr, noRepeats);
+        }
+    }
+    BoundsBatch::setLevel(supported);
+
+    if (bench.enabled("bounds.transform")) {
+        InstanceStore instances;
+        createInstances(instances, size, 2);
+        std::vector<BoundingRegion> regions = createRegions(instances);
+
+        bench.measure("bounds.transform", size, size, [&]() {
+            for (BoundingRegion& br : regions) {
+                br.transform();
+            }
+            sink += (unsigned long long)regions[0].center.x;
+        }, nullptr, noRepeats);
+
+        instances.clear();
+    }
+
+    // Object table in shuffled order (instances are scattered on the heap in the scene)
+    if (bench.enabled("bounds.transform.table.single") || bench.enabled("bounds.transform.table.batch")) {
+        InstanceStore instances;
+        createInstances(instances, size, 2);
+        std::vector<BoundingRegion> regions = createRegions(instances);
+        std::shuffle(regions.begin(), regions.end(), std::mt19937(4));
+
+        Octree::ObjectTable table;
+        for (BoundingRegion& br : regions) {
+            States::activate(&br.instance->state(), INSTANCE_MOVED);
+            table.add(br);
+        }
+        // The first pass sorts the shuffled objects by instance, later frames are measured
+        table.transformMoved();
+
+        if (bench.enabled("bounds.transform.table.single")) {
+            bench.measure("bounds.transform.table.single", size, size, [&]() {
+                for (unsigned int handle = 0; handle < size; ++handle) {
+                    table.transform(handle);
+                }
+                sink += (unsigned long long)table.minX[0];
+            }, nullptr, noRepeats);
+        }
+
+        if (bench.enabled("bounds.transform.table.batch")) {
+            bench.measure("bounds.transform.table.batch", size, size, [&]() {
+                sink += table.transformMoved();
+            }, nullptr, noRepeats);
+        }
+
+        instances.clear();
+    }
+}
+
+static void benchOctree(Bench& bench, unsigned int size) {
+    InstanceStore instances;
+    createInstances(instances, size, 3);
+    std::vector<BoundingRegion> regions = createRegions(instances);
+    float extent = worldExtent(size) + 1.0f;
+    BoundingRegion bounds(glm::vec3(-extent), glm::vec3(extent));
+
+    if (bench.enabled("octree.build")) {
+        Octree::node* root = nullptr;
+        bench.measure("octree.build", size, size, [&]() {
+            root->build();
+        }, [&]() {
+            delete root;
+            root = new Octree::node(bounds, regions);
+        });
+        delete root;
+    }
+
+    if (bench.enabled("octree.buildLinear")) {
+        Octree::node* root = nullptr;
+        bench.measure("octree.buildLinear", size, size, [&]() {
+            root->buildLinear();
+        }, [&]() {
+            delete root;
+            root = new Octree::node(bounds, regions);
+        });
+        delete root;
+    }
+
+    if (bench.enabled("octree.insert")) {
+        Octree::node* root = nullptr;
+        bench.measure("octree.insert", size, size, [&]() {
+            for (BoundingRegion& br : regions) {
+                root->insert(br);
+            }
+        }, [&]() {
+            // Insert into a built empty tree
+            delete root;
+            root = new Octree::node(bounds);
+            root->build();
+        });
+        delete root;
+    }
+
+    // Every other instance moves each frame, or one in a hundred (a mostly static scene)
+    // one update is size ops
+    const char* updateNames[] = { "octree.update", "octree.update.sparse" };
+    unsigned int moveStrides[] = { 2, 100 };
+    for (int u = 0; u < 2; ++u) {
+        if (!bench.enabled(updateNames[u])) {
+            continue;
+        }
+
+        Octree::node root(bounds, regions);
+        root.build();
+
+        for (unsigned char& state : instances.states) {
+            States::deactivate(&state, INSTANCE_MOVED);
+        }
+        root.update();
+
+        unsigned int noFrames = Bench::updateFramesFor(size);
+        bench.measure(updateNames[u], size, (unsigned long long)size * noFrames, [&]() {
+            for (unsigned int frame = 0; frame < noFrames; ++frame) {
+                for (unsigned int i = 1; i < size; i += moveStrides[u]) {
+                    instances.pos[i] += glm::vec3(0.1f, 0.0f, -0.1f);
+                    States::activate(&instances.states[i], INSTANCE_MOVED);
+                }
+                root.update();
+
+                // Moves are consumed by the update (as in Scene::update)
+                for (unsigned char& state : instances.states) {
+                    States::deactivate(&state, INSTANCE_MOVED);
+                }
+            }
+        });
+        root.destroy();
+    }
+
+    // Same frames on a serial and a parallel tree, both must end with the same objects and pairs
+    if (bench.enabled("octree.update.serial") || bench.enabled("octree.update.parallel")) {
+        unsigned int noThreads = std::max((unsigned int)BENCH_MIN_THREADS, Parallel::getNoThreads());
+        Octree::node serial(bounds, regions);
+        Octree::node parallel(bounds, regions);
+        serial.build();
+        parallel.build();
+
+        for (unsigned char& state : instances.states) {
+            States::deactivate(&state, INSTANCE_MOVED);
+        }
+        serial.update();
+        parallel.update();
+
+        unsigned int noFrames = Bench::updateFramesFor(size);
+        auto moveHalf = [&]() {
+            for (unsigned char& state : instances.states) {
+                States::deactivate(&state, INSTANCE_MOVED);
+            }
+            for (unsigned int i = 1; i < size; i += 2) {
+                instances.pos[i] += glm::vec3(0.1f, 0.0f, -0.1f);
+                States::activate(&instances.states[i], INSTANCE_MOVED);
+            }
+        };
+
+        bench.measure("octree.update.serial", size, size, [&]() {
+            serial.update();
+        }, moveHalf, noFrames);
+
+        // Catch the parallel tree up with the serial one's moves before its own frames
+        for (unsigned char& state : instances.states) {
+            States::activate(&state, INSTANCE_MOVED);
+        }
+        parallel.update();
+
+        bench.measure("octree.update.parallel", size, size, [&]() {
+            parallel.updateParallel(noThreads);
+        }, moveHalf, noFrames);
+
+        // Frames after the serial measurement moved the same instances again
+        for (unsigned char& state : instances.states) {
+            States::activate(&state, INSTANCE_MOVED);
+        }
+        serial.update();
+        for (unsigned char& state : instances.states) {
+            States::deactivate(&state, INSTANCE_MOVED);
+        }
+
+        unsigned int serialObjects = serial.collectStats().noObjects;
+        unsigned int parallelObjects = parallel.collectStats().noObjects;
+        std::vector<Octree::CollisionPair>& serialPairs = serial.pool->collisionPairs;
+        std::vector<Octree::CollisionPair>& parallelPairs = parallel.pool->collisionPairs;
+        bool same = serialObjects == parallelObjects && serialPairs == parallelPairs;
+
+        std::cerr << "octree.update n=" << size << ": " << noThreads << " threads, objects "
+            << serialObjects << "/" << parallelObjects << ", pairs "
+            << serialPairs.size() << "/" << parallelPairs.size()
+            << (same ? "" : " (serial and parallel differ)") << std::endl;
+        if (!same) {
+            bench.failed = true;
+        }
+
+        serial.destroy();
+        parallel.destroy();
+    }
+
+    // Rays from random points in random directions, one cast is one op (default loose tree)
+    if (bench.enabled("octree.castRay") || bench.enabled("octree.castRays")) {
+        Octree::node root(bounds, regions);
+        root.build();
+
+        unsigned int noRays = std::min(size, (unsigned int)BENCH_MAX_RAYS);
+        std::vector<glm::vec3> origins = randomPoints(noRays, extent, 5);
+        std::vector<glm::vec3> directions = randomPoints(noRays, 1.0f, 6);
+        std::vector<Ray> rays;
+        rays.reserve(noRays);
+        for (unsigned int i = 0; i < noRays; ++i) {
+            rays.push_back(Ray(origins[i], directions[i]));
+        }
+        std::vector<RayHit> hits;
+
+        if (bench.enabled("octree.castRay")) {
+            bench.measure("octree.castRay", size, noRays, [&]() {
+                unsigned long long count = 0;
+                RayHit hit;
+                for (Ray& ray : rays) {
+                    count += root.castRay(ray, hit);
+                }
+                sink += count;
+            });
+        }
+
+        if (bench.enabled("octree.castRays")) {
+            bench.measure("octree.castRays", size, noRays, [&]() {
+                root.castRays(rays, hits);
+                sink += hits.size();
+            });
+        }
+
+        // Regular octree (looseFactor 1), objects straddling split planes stay in large nodes
+        if (bench.enabled("octree.castRay.tight")) {
+            Octree::node tight(bounds, regions, 1.0f);
+            tight.build();
+
+            bench.measure("octree.castRay.tight", size, noRays, [&]() {
+                unsigned long long count = 0;
+                RayHit hit;
+                for (Ray& ray : rays) {
+                    count += tight.castRay(ray, hit);
+                }
+                sink += count;
+            });
+            tight.destroy();
+        }
+
+        root.destroy();
+    }
+
+    instances.clear();
+}
+
+static void benchTrie(Bench& bench, unsigned int size) {
+    std::vector<std::string> keys = createKeys(size);
+    trie::Trie<int> trie;
+
+    if (bench.enabled("trie.insert")) {
+        bench.measure("trie.insert", size, size, [&]() {
+            for (unsigned int i = 0; i < size; ++i) {
+                trie.insert(keys[i], i);
+            }
+        });
+    }
+    else {
+        for (unsigned int i = 0; i < size; ++i) {
+            trie.insert(keys[i], i);
+        }
+    }
+
+    if (bench.enabled("trie.containsKey")) {
+        bench.measure("trie.containsKey", size, size, [&]() {
+            unsigned long long count = 0;
+            for (std::string& key : keys) {
+                count += trie.containsKey(key);
+            }
+            sink += count;
+        });
+    }
+
+    if (bench.enabled("trie.lookup")) {
+        bench.measure("trie.lookup", size, size, [&]() {
+            unsigned long long sum = 0;
+            for (std::string& key : keys) {
+                sum += trie[key];
+            }
+            sink += sum;
+        });
+    }
+
+    if (bench.enabled("trie.traverse")) {
+        bench.measure("trie.traverse", size, size, [&]() {
+            trie.traverse(traverseItem);
+        });
+    }
+
+    if (bench.enabled("trie.erase")) {
+        bench.measure("trie.erase", size, size, [&]() {
+            unsigned long long count = 0;
+            for (std::string& key : keys) {
+                count += trie.erase(key);
+            }
+            sink += count;
+        });
+    }
+
+    trie.cleanup();
+}
+
+static void benchSlotMap(Bench& bench, unsigned int size) {
+    slotmap::SlotMap<int> slots;
+    std::vector<slotmap::Handle> handles(size);
+
+    // Spawn and despawn a batch of size, like projectiles
+    if (bench.enabled("slotmap.churn")) {
+        bench.measure("slotmap.churn", size, 2ull * size, [&]() {
+            for (unsigned int i = 0; i < size; ++i) {
+                handles[i] = slots.insert(i);
+            }
+            for (unsigned int i = 0; i < size; ++i) {
+                slots.erase(handles[i]);
+            }
+        }, nullptr, Bench::repeatsFor(size));
+    }
+
+    for (unsigned int i = 0; i < size; ++i) {
+        handles[i] = slots.insert(i);
+    }
+
+    if (bench.enabled("slotmap.get")) {
+        bench.measure("slotmap.get", size, size, [&]() {
+            unsigned long long sum = 0;
+            for (slotmap::Handle& handle : handles) {
+                sum += *slots.get(handle);
+            }
+            sink += sum;
+        }, nullptr, Bench::repeatsFor(size));
+    }
+}
+
+static void benchRigidBody(Bench& bench, unsigned int size) {
+    InstanceStore instances;
+    createInstances(instances, size, 4);
+    for (RigidBody* rb : instances.bodies) {
+        rb->applyAcceleration(glm::vec3(0.0f, -9.81f, 0.0f));
+    }
+
+    // One body at a time through its handle
+    if (bench.enabled("rigidbody.update")) {
+        bench.measure("rigidbody.update", size, size, [&]() {
+            for (RigidBody* rb : instances.bodies) {
+                rb->update(BENCH_DT);
+            }
+            sink += (unsigned long long)instances.pos[0].y;
+        }, nullptr, Bench::repeatsFor(size));
+    }
+
+    // Whole store with the batched integrator at each level (single thread)
+    const char* levelNames[] = { "scalar", "sse", "avx2" };
+    BoundsBatch::SimdLevel supported = BoundsBatch::getSupportedLevel();
+    for (int level = 0; level <= (int)supported; ++level) {
+        BoundsBatch::setLevel((BoundsBatch::SimdLevel)level);
+
+        std::string name = std::string("rigidbody.integrate.") + levelNames[level];
+        if (bench.enabled(name)) {
+            bench.measure(name, size, size, [&]() {
+                Integrator::integrate(instances, BENCH_DT, 1);
+                sink += (unsigned long long)instances.pos[0].y;
+            }, nullptr, Bench::repeatsFor(size));
+        }
+    }
+    BoundsBatch::setLevel(supported);
+
+    // Split across worker threads
+    if (bench.enabled("rigidbody.integrate.threads")) {
+        bench.measure("rigidbody.integrate.threads", size, size, [&]() {
+            Integrator::integrate(instances, BENCH_DT);
+            sink += (unsigned long long)instances.pos[0].y;
+        }, nullptr, Bench::repeatsFor(size));
+    }
+
+    instances.clear();
+}
+
+int main(int argc, char** argv) {
+    Bench bench;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--min" && hasValue) {
+            bench.minSize = std::stoul(argv[++i]);
+        }
+        else if (arg == "--max" && hasValue) {
+            bench.maxSize = std::stoul(argv[++i]);
+        }
+        else if (arg == "--filter" && hasValue) {
+            bench.filter = argv[++i];
+        }
+        else if (arg == "--out" && hasValue) {
+            bench.outPath = argv[++i];
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--min N] [--max N] [--filter text] [--out file.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (bench.minSize == 0 || bench.minSize > bench.maxSize) {
+        std::cerr << "invalid size range" << std::endl;
+        return 1;
+    }
+
+    // Fail before measuring, results are written as they complete
+    if (!bench.outPath.empty() && !bench.writeFile()) {
+        std::cerr << "could not open " << bench.outPath << std::endl;
+        return 1;
+    }
+
+    for (unsigned int size : bench.sizes()) {
+        benchBounds(bench, size);
+        benchOctree(bench, size);
+        benchTrie(bench, size);
+        benchSlotMap(bench, size);
+        benchRigidBody(bench, size);
+    }
+
+    if (bench.outPath.empty()) {
+        bench.writeJSON(std::cout);
+    }
+
+    return bench.failed ? 1 : 0;
+}
@@ -0,0 +1,821 @@
+/*
+    engine_tests
+    - headless unit tests for user_algorithms and physics (no window or GL context)
+    - every case is checked against a plain reference (std containers, brute force or the scalar path)
+
+    usage: engine_tests [--filter text]
+    - exits 1 if any check failed
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../algorithms/Bounds.hpp"
+#include "../algorithms/BoundsBatch.hpp"
+#include "../algorithms/DirtyRanges.hpp"
+#include "../algorithms/InternedId.hpp"
+#include "../algorithms/SlotMap.hpp"
+#include "../algorithms/Trie.hpp"
+#include "../physics/InstanceStore.hpp"
+#include "../physics/Integrator.hpp"
+#include "../physics/RigidBody.hpp"
+
+#define TESTS_SEED          1234
+#define TESTS_NO_KEYS       5000        // random keys per trie case
+#define TESTS_NO_OPS        20000       // random inserts/erases per slot map case
+#define TESTS_NO_ELEMENTS   4096        // array size of dirty range cases
+#define TESTS_NO_ROUNDS     200         // random mark sequences per dirty range case
+#define TESTS_NO_NAMES      100000      // distinct names per interned id case
+#define TESTS_NO_BOUNDS     1000        // boxes/spheres per batch (not a multiple of any lane count)
+#define TESTS_NO_QUERIES    200         // query regions per batch kernel
+#define TESTS_NO_STEPS      3           // integration steps per integrator case
+#define TESTS_DT            0.016f
+
+/*
+    Checks
+*/
+
+class Tests {
+public:
+    std::string filter;
+    unsigned int noChecks;
+    unsigned int noFailures;
+
+    Tests()
+        : noChecks(0), noFailures(0) {}
+
+    bool enabled(std::string name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Start case name, returns false if it is filtered out
+    bool start(std::string name) {
+        if (!enabled(name)) {
+            return false;
+        }
+        current = name;
+        std::cerr << name << std::endl;
+        return true;
+    }
+
+    // Record a check, prints what failed
+    bool check(bool condition, std::string what) {
+        ++noChecks;
+        if (!condition) {
+            ++noFailures;
+            std::cerr << "  FAIL " << current << ": " << what << std::endl;
+        }
+        return condition;
+    }
+
+private:
+    std::string current;
+};
+
+/*
+    Trie
+*/
+
+// Keys seen by Trie::traverse (the callback can't capture)
+static std::vector<int> traversed;
+
+static void collectTraversed(int data) {
+    traversed.push_back(data);
+}
+
+static std::string randomKey(std::mt19937& rng, const std::string& chars, unsigned int maxLength) {
+    std::uniform_int_distribution<unsigned int> length(1, maxLength);
+    std::uniform_int_distribution<size_t> pick(0, chars.size() - 1);
+
+    std::string ret(length(rng), ' ');
+    for (char& c : ret) {
+        c = chars[pick(rng)];
+    }
+    return ret;
+}
+
+// Trie holds the same keys as map (traverse visits them in key order, charset order is ASCII order)
+static bool sameKeys(trie::Trie<int>& t, std::map<std::string, int>& reference) {
+    if (t.size() != reference.size()) {
+        return false;
+    }
+
+    traversed.clear();
+    t.traverse(collectTraversed);
+    if (traversed.size() != reference.size()) {
+        return false;
+    }
+
+    size_t i = 0;
+    for (auto& item : reference) {
+        if (!t.containsKey(item.first) || t[item.first] != item.second || traversed[i++] != item.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testTrie(Tests& tests) {
+    if (!tests.start("trie")) {
+        return;
+    }
+
+    std::mt19937 rng(TESTS_SEED);
+    std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+    trie::Trie<int> t;
+    std::map<std::string, int> reference;
+
+    // Random inserts (short keys share prefixes, so nodes fill up and grow through all types)
+    for (int i = 0; i < TESTS_NO_KEYS; ++i) {
+        std::string key = randomKey(rng, chars, 4);
+        bool added = !t.containsKey(key);
+        tests.check(added == (reference.count(key) == 0), "containsKey before insert " + key);
+        tests.check(t.insert(key, i), "insert " + key);
+        reference[key] = i;
+    }
+    tests.check(sameKeys(t, reference), "keys after inserts");
+
+    trie::MemoryReport report = t.memoryReport();
+    tests.check(report.noKeys == reference.size(), "memory report keys");
+    for (int type = 0; type < TRIE_NO_NODE_TYPES; ++type) {
+        tests.check(report.noNodes[type] > 0, "node type " + std::to_string(type) + " in use");
+    }
+
+    // Keys outside the charset are rejected without leaving nodes behind
+    tests.check(!t.insert("ab-c", 1), "insert invalid key");
+    tests.check(!t.containsKey("ab-c"), "containsKey invalid key");
+    trie::MemoryReport after = t.memoryReport();
+    tests.check(after.bytes == report.bytes, "invalid key leaves no nodes");
+
+    bool thrown = false;
+    try {
+        t["not-a-key"];
+    }
+    catch (std::invalid_argument&) {
+        thrown = true;
+    }
+    tests.check(thrown, "operator[] throws for missing key");
+
+    // Erase half, prefixes of erased keys stay if they hold data
+    std::vector<std::string> keys;
+    for (auto& item : reference) {
+        keys.push_back(item.first);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (size_t i = 0; i < keys.size() / 2; ++i) {
+        tests.check(t.erase(keys[i]), "erase " + keys[i]);
+        tests.check(!t.erase(keys[i]), "erase twice " + keys[i]);
+        reference.erase(keys[i]);
+    }
+    tests.check(sameKeys(t, reference), "keys after erasing half");
+
+    // Erasing everything shrinks back to the root
+    for (size_t i = keys.size() / 2; i < keys.size(); ++i) {
+        t.erase(keys[i]);
+        reference.erase(keys[i]);
+    }
+    report = t.memoryReport();
+    tests.check(t.size() == 0 && report.noNodes[(int)trie::NodeType::NODE4] == 1, "empty trie is only the root");
+    for (int type = 1; type < TRIE_NO_NODE_TYPES; ++type) {
+        tests.check(report.noNodes[type] == 0, "no node of type " + std::to_string(type) + " left");
+    }
+
+    // Moves hand the nodes over
+    t.insert("moved", 7);
+    trie::Trie<int> moved(std::move(t));
+    tests.check(moved.containsKey("moved") && moved["moved"] == 7 && moved.size() == 1, "move constructor");
+    t = std::move(moved);
+    tests.check(t.containsKey("moved") && t.size() == 1, "move assignment");
+
+    t.cleanup();
+    tests.check(t.size() == 0 && !t.containsKey("moved"), "cleanup");
+}
+
+/*
+    SlotMap
+*/
+
+// Every live handle resolves to its value and the dense array holds exactly the live values
+static bool sameElements(slotmap::SlotMap<int>& map, std::vector<std::pair<slotmap::Handle, int>>& live) {
+    if (map.size() != live.size() || map.values().size() != live.size()) {
+        return false;
+    }
+
+    for (auto& item : live) {
+        int* value = map.get(item.first);
+        if (!value || *value != item.second) {
+            return false;
+        }
+    }
+
+    // Dense positions map back to the handles that reach them
+    for (unsigned int i = 0; i < map.size(); ++i) {
+        if (map.get(map.getHandle(i)) != &map.values()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSlotMap(Tests& tests) {
+    if (!tests.start("slotmap")) {
+        return;
+    }
+
+    std::mt19937 rng(TESTS_SEED);
+    slotmap::SlotMap<int> map;
+    std::vector<std::pair<slotmap::Handle, int>> live;
+    std::vector<slotmap::Handle> stale;
+
+    tests.check(!map.contains(slotmap::nullHandle) && !map.get(slotmap::nullHandle), "null handle");
+
+    // Random inserts and erases (erase picks any live element, so holes are filled from the back)
+    for (int i = 0; i < TESTS_NO_OPS; ++i) {
+        if (live.empty() || rng() % 3 != 0) {
+            live.push_back({ map.insert(i), i });
+        }
+        else {
+            size_t pick = rng() % live.size();
+            tests.check(map.erase(live[pick].first), "erase live handle");
+            stale.push_back(live[pick].first);
+            live[pick] = live.back();
+            live.pop_back();
+        }
+    }
+    tests.check(sameElements(map, live), "elements after random ops");
+
+    // Erased handles stay stale even though their slots were recycled
+    bool staleOk = true;
+    for (slotmap::Handle handle : stale) {
+        staleOk = staleOk && !map.contains(handle) && !map.get(handle) && !map.erase(handle);
+    }
+    tests.check(staleOk, "stale handles rejected");
+
+    // Recycled slot: same index, new generation
+    slotmap::Handle erased = live.back().first;
+    map.erase(erased);
+    live.pop_back();
+    slotmap::Handle reused = map.insert(-1);
+    live.push_back({ reused, -1 });
+    tests.check(reused.index == erased.index && reused.generation != erased.generation, "slot reused with new generation");
+    tests.check(!map.contains(erased) && map.contains(reused), "old handle to reused slot");
+    tests.check(sameElements(map, live), "elements after reuse");
+
+    // Clear makes every handle stale, slots are recycled afterwards
+    map.clear();
+    tests.check(map.size() == 0 && map.values().empty(), "clear empties");
+    bool cleared = true;
+    for (auto& item : live) {
+        cleared = cleared && !map.contains(item.first);
+    }
+    tests.check(cleared, "clear makes handles stale");
+
+    live.clear();
+    for (int i = 0; i < 100; ++i) {
+        live.push_back({ map.insert(i), i });
+    }
+    tests.check(sameElements(map, live), "elements after clear");
+    tests.check(map.memoryUsage() > 0, "memory usage");
+}
+
+/*
+    DirtyRanges
+*/
+
+// Spans are sorted, non-empty, more than mergeGap apart and within maxSpans
+static bool wellFormed(DirtyRanges& ranges) {
+    std::vector<DirtyRanges::Span>& spans = ranges.getSpans();
+    if (spans.size() > ranges.maxSpans) {
+        return false;
+    }
+
+    for (size_t i = 0; i < spans.size(); ++i) {
+        if (spans[i].begin >= spans[i].end) {
+            return false;
+        }
+        if (i > 0 && spans[i].begin <= spans[i - 1].end + ranges.mergeGap) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every marked element lies in a span
+static bool covers(DirtyRanges& ranges, std::vector<bool>& marked) {
+    std::vector<bool> inSpan(marked.size(), false);
+    for (DirtyRanges::Span& span : ranges.getSpans()) {
+        for (unsigned int i = span.begin; i < span.end && i < marked.size(); ++i) {
+            inSpan[i] = true;
+        }
+    }
+
+    for (size_t i = 0; i < marked.size(); ++i) {
+        if (marked[i] && !inSpan[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs of marked elements, joined where at most mergeGap elements lie between them
+static std::vector<DirtyRanges::Span> bridgedRuns(std::vector<bool>& marked, unsigned int mergeGap) {
+    std::vector<DirtyRanges::Span> ret;
+    for (unsigned int i = 0; i < marked.size(); ++i) {
+        if (!marked[i]) {
+            continue;
+        }
+
+        if (ret.size() > 0 && i <= ret.back().end + mergeGap) {
+            ret.back().end = i + 1;
+        }
+        else {
+            ret.push_back({ i, i + 1 });
+        }
+    }
+    return ret;
+}
+
+static bool sameSpans(std::vector<DirtyRanges::Span>& a, std::vector<DirtyRanges::Span>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].begin != b[i].begin || a[i].end != b[i].end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testDirtyRanges(Tests& tests) {
+    if (!tests.start("dirtyranges")) {
+        return;
+    }
+
+    std::mt19937 rng(TESTS_SEED);
+    unsigned int maxSpans[] = { 1, 4, DIRTY_MAX_SPANS, TESTS_NO_ELEMENTS };
+    unsigned int mergeGaps[] = { 0, 1, DIRTY_MERGE_GAP };
+
+    for (int round = 0; round < TESTS_NO_ROUNDS; ++round) {
+        // Sparse rounds leave gaps to bridge, dense ones overlap
+        unsigned int noMarks = 1 + rng() % (round % 2 ? 256 : 16);
+        unsigned int maxLength = 1 + rng() % 32;
+
+        std::vector<DirtyRanges::Span> marks(noMarks);
+        std::vector<bool> marked(TESTS_NO_ELEMENTS, false);
+        for (DirtyRanges::Span& mark : marks) {
+            mark.begin = rng() % TESTS_NO_ELEMENTS;
+            mark.end = std::min(mark.begin + (unsigned int)(rng() % maxLength), (unsigned int)TESTS_NO_ELEMENTS);
+            for (unsigned int i = mark.begin; i < mark.end; ++i) {
+                marked[i] = true;
+            }
+        }
+
+        // Increasing order takes the fast path, shuffled order the sorted insert
+        std::vector<DirtyRanges::Span> sorted = marks;
+        std::sort(sorted.begin(), sorted.end(), [](const DirtyRanges::Span& a, const DirtyRanges::Span& b) {
+            return a.begin < b.begin;
+        });
+
+        for (unsigned int spans : maxSpans) {
+            for (unsigned int gap : mergeGaps) {
+                std::string name = "spans=" + std::to_string(spans) + " gap=" + std::to_string(gap) +
+                    " round=" + std::to_string(round);
+                DirtyRanges inOrder(spans, gap);
+                DirtyRanges shuffled(spans, gap);
+                for (size_t i = 0; i < marks.size(); ++i) {
+                    inOrder.mark(sorted[i].begin, sorted[i].end);
+                    shuffled.mark(marks[i].begin, marks[i].end);
+                }
+
+                for (DirtyRanges* ranges : { &inOrder, &shuffled }) {
+                    tests.check(wellFormed(*ranges), "well formed " + name);
+                    tests.check(covers(*ranges, marked), "covers marks " + name);
+                }
+
+                // With room for every span nothing is merged past the gap, both orders give the bridged runs
+                if (spans == TESTS_NO_ELEMENTS) {
+                    std::vector<DirtyRanges::Span> expected = bridgedRuns(marked, gap);
+                    tests.check(sameSpans(inOrder.getSpans(), expected), "in order spans " + name);
+                    tests.check(sameSpans(shuffled.getSpans(), expected), "shuffled spans " + name);
+                }
+
+                // Clamping drops what lies past the new size only
+                unsigned int size = rng() % TESTS_NO_ELEMENTS;
+                std::vector<bool> kept(marked.begin(), marked.begin() + size);
+                shuffled.clamp(size);
+                bool inside = true;
+                for (DirtyRanges::Span& span : shuffled.getSpans()) {
+                    inside = inside && span.end <= size;
+                }
+                tests.check(inside && wellFormed(shuffled) && covers(shuffled, kept), "clamp " + name);
+            }
+        }
+    }
+
+    // Single elements and empty marks
+    DirtyRanges ranges;
+    ranges.mark(5, 5);
+    tests.check(ranges.empty(), "empty mark ignored");
+    ranges.mark(10);
+    ranges.mark(11);
+    tests.check(ranges.getSpans().size() == 1 && ranges.noElements() == 2, "adjacent elements join");
+    ranges.clear();
+    tests.check(ranges.empty() && ranges.noElements() == 0, "clear");
+}
+
+/*
+    InternedId
+*/
+
+// Published FNV-1a 64 vectors, checked at compile time
+static_assert(interned::hash("") == FNV_OFFSET_BASIS, "FNV-1a of empty string");
+static_assert(interned::hash("a") == 0xaf63dc4c8601ec8cull, "FNV-1a of \"a\"");
+static_assert(interned::hash("foobar") == 0x85944171f73967e8ull, "FNV-1a of \"foobar\"");
+
+// Distinct names with the same FNV-1a 64 id (0x180816d9e82588cb, found by a rho search)
+static const char* collidingNames[] = { "86eb99930728f8a3", "39765b62eb92a227" };
+
+// Intern name, returns true if the registry threw for a collision naming both names
+static bool internThrows(interned::Registry& registry, std::string name, std::string other) {
+    try {
+        registry.intern(name);
+    }
+    catch (std::runtime_error& e) {
+        std::string what = e.what();
+        return what.find(name) != std::string::npos && what.find(other) != std::string::npos;
+    }
+    return false;
+}
+
+static void testInternedId(Tests& tests) {
+    if (!tests.start("internedid")) {
+        return;
+    }
+
+    // All overloads agree, the length overload reads embedded nulls
+    std::string withNull("ab\0c", 4);
+    tests.check(interned::hash(std::string("foobar")) == interned::hash("foobar", 6), "string and length overloads");
+    tests.check(interned::hash(withNull) == interned::hash(withNull.c_str(), 4) &&
+        interned::hash(withNull) != interned::hash("ab"), "embedded null");
+
+    // Interning is idempotent and keeps the name
+    interned::Registry registry;
+    interned::Id id = registry.intern("sphere");
+    tests.check(id == interned::hash("sphere") && registry.intern("sphere") == id, "intern returns hash");
+    tests.check(registry.size() == 1 && registry.contains(id) && registry.getName(id) == "sphere", "name kept");
+    tests.check(!registry.contains(interned::hash("cube")) && registry.getName(interned::hash("cube")).empty(), "unknown id");
+
+    // Many distinct names, no false collisions
+    bool noThrow = true;
+    try {
+        for (int i = 0; i < TESTS_NO_NAMES; ++i) {
+            registry.intern("instance" + std::to_string(i));
+        }
+    }
+    catch (std::runtime_error&) {
+        noThrow = false;
+    }
+    tests.check(noThrow && registry.size() == TESTS_NO_NAMES + 1, "distinct names");
+
+    // A real collision throws in either order and leaves the first name in place
+    interned::Id collision = interned::hash(collidingNames[0]);
+    tests.check(collision == interned::hash(collidingNames[1]), "colliding names share an id");
+    for (int first = 0; first < 2; ++first) {
+        std::string name = collidingNames[first];
+        std::string other = collidingNames[1 - first];
+
+        interned::Registry colliding;
+        colliding.intern(name);
+        tests.check(internThrows(colliding, other, name), "collision throws, " + name + " first");
+        tests.check(colliding.size() == 1 && colliding.getName(collision) == name, "first name kept, " + name + " first");
+        tests.check(colliding.intern(name) == collision, "first name still interns, " + name + " first");
+    }
+}
+
+/*
+    BoundsBatch
+*/
+
+static const char* levelNames[] = { "scalar", "sse", "avx2" };
+
+// Coordinates on a quarter grid, products and sums stay exact so touching regions are common and
+// every level has to agree with the Bounds reference bit for bit
+static float gridCoordinate(std::mt19937& rng, int extent) {
+    return (float)((int)(rng() % (8 * extent + 1)) - 4 * extent) / 4.0f;
+}
+
+static AABB randomBox(std::mt19937& rng) {
+    glm::vec3 min(gridCoordinate(rng, 8), gridCoordinate(rng, 8), gridCoordinate(rng, 8));
+    glm::vec3 dimensions(gridCoordinate(rng, 2), gridCoordinate(rng, 2), gridCoordinate(rng, 2));
+    return { min, min + glm::abs(dimensions) };
+}
+
+static BoundingSphere randomSphere(std::mt19937& rng) {
+    return { glm::vec3(gridCoordinate(rng, 8), gridCoordinate(rng, 8), gridCoordinate(rng, 8)),
+        std::abs(gridCoordinate(rng, 2)) };
+}
+
+// Structure of arrays for spheres
+struct SphereList {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    void push_back(BoundingSphere sphere) {
+        x.push_back(sphere.center.x);
+        y.push_back(sphere.center.y);
+        z.push_back(sphere.center.z);
+        radius.push_back(sphere.radius);
+    }
+
+    BoundsBatch::SphereArrays arrays() {
+        return { x.data(), y.data(), z.data(), radius.data() };
+    }
+};
+
+// Indices in [begin, end) passing test, in order
+template <typename F>
+static std::vector<unsigned int> expectedHits(unsigned int begin, unsigned int end, F test) {
+    std::vector<unsigned int> ret;
+    for (unsigned int i = begin; i < end; ++i) {
+        if (test(i)) {
+            ret.push_back(i);
+        }
+    }
+    return ret;
+}
+
+static bool sameHits(std::vector<unsigned int>& hits, unsigned int noHits, std::vector<unsigned int>& expected) {
+    return noHits == expected.size() && std::equal(expected.begin(), expected.end(), hits.begin());
+}
+
+static bool sameFloats(std::vector<float>& a, std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static void testBoundsBatch(Tests& tests) {
+    if (!tests.start("boundsbatch")) {
+        return;
+    }
+
+    std::mt19937 rng(TESTS_SEED);
+    std::vector<AABB> boxes;
+    std::vector<BoundingSphere> spheres;
+    BoundsBatch::BoxList boxList;
+    SphereList sphereList;
+    for (int i = 0; i < TESTS_NO_BOUNDS; ++i) {
+        boxes.push_back(randomBox(rng));
+        spheres.push_back(randomSphere(rng));
+        boxList.push_back(boxes.back().min, boxes.back().max);
+        sphereList.push_back(spheres.back());
+    }
+
+    // Instance transforms, arbitrary floats (kernels have to match the scalar expressions exactly)
+    std::uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> sizeDist(0.1f, 10.0f);
+    std::vector<float> pos[3];
+    std::vector<float> size[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int i = 0; i < TESTS_NO_BOUNDS; ++i) {
+            pos[axis].push_back(posDist(rng));
+            size[axis].push_back(sizeDist(rng));
+        }
+    }
+    BoundsBatch::TransformArrays transforms = {
+        pos[0].data(), pos[1].data(), pos[2].data(), size[0].data(), size[1].data(), size[2].data()
+    };
+
+    // Reference transforms
+    BoundsBatch::BoxList boxesMoved;
+    BoundsBatch::BoxList spheresMoved;
+    for (int i = 0; i < TESTS_NO_BOUNDS; ++i) {
+        glm::vec3 p(pos[0][i], pos[1][i], pos[2][i]);
+        glm::vec3 s(size[0][i], size[1][i], size[2][i]);
+
+        AABB box = boxes[i].transform(p, s);
+        boxesMoved.push_back(box.min, box.max);
+
+        BoundingSphere sphere = BoundingSphere{ boxes[i].calculateCenter(), (boxes[i].max.x - boxes[i].min.x) / 2.0f }.transform(p, s);
+        spheresMoved.push_back(sphere.center - sphere.radius, sphere.center + sphere.radius);
+    }
+
+    std::vector<unsigned int> hits(TESTS_NO_BOUNDS);
+    BoundsBatch::SimdLevel supported = BoundsBatch::getSupportedLevel();
+
+    for (int level = 0; level <= (int)supported; ++level) {
+        BoundsBatch::setLevel((BoundsBatch::SimdLevel)level);
+        std::string name = levelNames[level];
+        tests.check(BoundsBatch::getLevel() == (BoundsBatch::SimdLevel)level, "level set " + name);
+
+        bool boxBoxOk = true, sphereSphereOk = true, sphereBoxOk = true, boxSphereOk = true;
+        for (int q = 0; q < TESTS_NO_QUERIES; ++q) {
+            // Ranges start and end off the lane boundaries
+            unsigned int begin = rng() % 11;
+            unsigned int end = TESTS_NO_BOUNDS - rng() % 11;
+            if (q % 10 == 0) {
+                end = begin + rng() % 9;
+            }
+
+            AABB box = randomBox(rng);
+            BoundingSphere sphere = randomSphere(rng);
+
+            std::vector<unsigned int> expected = expectedHits(begin, end, [&](unsigned int i) {
+                return Bounds::intersects(box, boxes[i]);
+            });
+            unsigned int noHits = BoundsBatch::intersectBoxes(box.min, box.max, boxList.arrays(), begin, end, hits.data());
+            boxBoxOk = boxBoxOk && sameHits(hits, noHits, expected);
+
+            expected = expectedHits(begin, end, [&](unsigned int i) {
+                return Bounds::intersects(sphere, spheres[i]);
+            });
+            noHits = BoundsBatch::intersectSpheres(sphere.center, sphere.radius, sphereList.arrays(), begin, end, hits.data());
+            sphereSphereOk = sphereSphereOk && sameHits(hits, noHits, expected);
+
+            expected = expectedHits(begin, end, [&](unsigned int i) {
+                return Bounds::intersects(sphere, boxes[i]);
+            });
+            noHits = BoundsBatch::intersectSphereBoxes(sphere.center, sphere.radius, boxList.arrays(), begin, end, hits.data());
+            sphereBoxOk = sphereBoxOk && sameHits(hits, noHits, expected);
+
+            expected = expectedHits(begin, end, [&](unsigned int i) {
+                return Bounds::intersects(box, spheres[i]);
+            });
+            noHits = BoundsBatch::intersectBoxSpheres(box.min, box.max, sphereList.arrays(), begin, end, hits.data());
+            boxSphereOk = boxSphereOk && sameHits(hits, noHits, expected);
+        }
+        tests.check(boxBoxOk, "box against boxes " + name);
+        tests.check(sphereSphereOk, "sphere against spheres " + name);
+        tests.check(sphereBoxOk, "sphere against boxes " + name);
+        tests.check(boxSphereOk, "box against spheres " + name);
+
+        // Transforms over an unaligned range, entries outside it stay untouched
+        unsigned int begin = 3;
+        unsigned int end = TESTS_NO_BOUNDS - 5;
+        BoundsBatch::BoxList out;
+        out.resize(TESTS_NO_BOUNDS);
+        BoundsBatch::transformBoxes(boxList.arrays(), transforms, out.outArrays(), begin, end);
+        bool transformOk = true;
+        for (unsigned int i = 0; i < TESTS_NO_BOUNDS; ++i) {
+            bool inRange = i >= begin && i < end;
+            glm::vec3 expectedMin = inRange ? glm::vec3(boxesMoved.minX[i], boxesMoved.minY[i], boxesMoved.minZ[i]) : glm::vec3(0.0f);
+            glm::vec3 expectedMax = inRange ? glm::vec3(boxesMoved.maxX[i], boxesMoved.maxY[i], boxesMoved.maxZ[i]) : glm::vec3(0.0f);
+            transformOk = transformOk &&
+                glm::vec3(out.minX[i], out.minY[i], out.minZ[i]) == expectedMin &&
+                glm::vec3(out.maxX[i], out.maxY[i], out.maxZ[i]) == expectedMax;
+        }
+        tests.check(transformOk, "transform boxes " + name);
+
+        out.clear();
+        out.resize(TESTS_NO_BOUNDS);
+        BoundsBatch::transformSpheres(boxList.arrays(), transforms, out.outArrays(), 0, TESTS_NO_BOUNDS);
+        tests.check(sameFloats(out.minX, spheresMoved.minX) && sameFloats(out.minY, spheresMoved.minY) &&
+            sameFloats(out.minZ, spheresMoved.minZ) && sameFloats(out.maxX, spheresMoved.maxX) &&
+            sameFloats(out.maxY, spheresMoved.maxY) && sameFloats(out.maxZ, spheresMoved.maxZ), "transform spheres " + name);
+    }
+
+    std::cerr << "  levels up to " << levelNames[(int)supported] << std::endl;
+    BoundsBatch::setLevel(supported);
+}
+
+/*
+    Integrator
+*/
+
+// Random floats with the values a vector path could get wrong mixed in
+static std::vector<float> integratorInput(std::mt19937& rng, unsigned int size) {
+    const float specials[] = {
+        0.0f, -0.0f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::min(), std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()
+    };
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+
+    std::vector<float> ret(size);
+    for (float& f : ret) {
+        f = rng() % 16 == 0 ? specials[rng() % (sizeof(specials) / sizeof(float))] : dist(rng);
+    }
+    return ret;
+}
+
+// Store of size instances, same random state for every seed
+static void fillStore(InstanceStore& instances, unsigned int size, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+
+    for (unsigned int i = 0; i < size; ++i) {
+        RigidBody* rb = instances.add(interned::hash("test"), glm::vec3(1.0f), 1.0f, glm::vec3(dist(rng), dist(rng), dist(rng)));
+        rb->velocity() = glm::vec3(dist(rng), dist(rng), dist(rng));
+        rb->acceleration() = glm::vec3(dist(rng), dist(rng), dist(rng));
+    }
+}
+
+static bool sameVectors(std::vector<glm::vec3>& a, std::vector<glm::vec3>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(glm::vec3)) == 0;
+}
+
+static void testIntegrator(Tests& tests) {
+    if (!tests.start("integrator")) {
+        return;
+    }
+
+    std::mt19937 rng(TESTS_SEED);
+    BoundsBatch::SimdLevel supported = BoundsBatch::getSupportedLevel();
+
+    // Flat kernel against the scalar path, unaligned ranges and special values, bit for bit
+    unsigned int size = 3 * 1000 + 1;
+    std::vector<float> pos = integratorInput(rng, size);
+    std::vector<float> velocity = integratorInput(rng, size);
+    std::vector<float> acceleration = integratorInput(rng, size);
+
+    for (int level = 0; level <= (int)supported; ++level) {
+        BoundsBatch::setLevel((BoundsBatch::SimdLevel)level);
+        std::string name = levelNames[level];
+
+        bool same = true;
+        for (unsigned int begin = 0; begin < 9; begin += 4) {
+            unsigned int end = size - begin;
+            std::vector<float> expectedPos = pos, expectedVelocity = velocity;
+            std::vector<float> gotPos = pos, gotVelocity = velocity;
+
+            Integrator::integrateScalar(expectedPos.data(), expectedVelocity.data(), acceleration.data(), begin, end, TESTS_DT);
+            Integrator::integrate(gotPos.data(), gotVelocity.data(), acceleration.data(), begin, end, TESTS_DT);
+            same = same && sameFloats(gotPos, expectedPos) && sameFloats(gotVelocity, expectedVelocity);
+        }
+        tests.check(same, "flat kernel " + name);
+    }
+
+    // Store integration against RigidBody::update, split across threads once the store is large enough
+    unsigned int noInstances = 2 * INTEGRATOR_THREAD_MIN + 7;
+    InstanceStore expected;
+    fillStore(expected, noInstances, TESTS_SEED);
+    for (int step = 0; step < TESTS_NO_STEPS; ++step) {
+        for (RigidBody* rb : expected.bodies) {
+            rb->update(TESTS_DT);
+        }
+    }
+
+    unsigned int threads[] = { 1, 2 };
+    for (int level = 0; level <= (int)supported; ++level) {
+        BoundsBatch::setLevel((BoundsBatch::SimdLevel)level);
+        for (unsigned int noThreads : threads) {
+            std::string name = std::string(levelNames[level]) + " threads=" + std::to_string(noThreads);
+
+            InstanceStore instances;
+            fillStore(instances, noInstances, TESTS_SEED);
+            for (int step = 0; step < TESTS_NO_STEPS; ++step) {
+                Integrator::integrate(instances, TESTS_DT, noThreads);
+            }
+            tests.check(sameVectors(instances.pos, expected.pos) && sameVectors(instances.velocity, expected.velocity),
+                "store against RigidBody::update " + name);
+            instances.clear();
+        }
+    }
+
+    // Verify mode finds nothing to report on the same store
+    InstanceStore instances;
+    fillStore(instances, noInstances, TESTS_SEED);
+    Integrator::setVerify(true);
+    Integrator::resetMismatches();
+    Integrator::integrate(instances, TESTS_DT);
+    tests.check(Integrator::getNoMismatches() == 0, "verify mode");
+    Integrator::setVerify(false);
+
+    instances.clear();
+    expected.clear();
+    BoundsBatch::setLevel(supported);
+}
+
+int main(int argc, char** argv) {
+    Tests tests;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            tests.filter = argv[++i];
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--filter text]" << std::endl;
+            return 1;
+        }
+    }
+
+    testTrie(tests);
+    testSlotMap(tests);
+    testDirtyRanges(tests);
+    testInternedId(tests);
+    testBoundsBatch(tests);
+    testIntegrator(tests);
+
+    std::cerr << tests.noChecks - tests.noFailures << "/" << tests.noChecks << " checks passed" << std::endl;
+    return tests.noFailures == 0 ? 0 : 1;
+}
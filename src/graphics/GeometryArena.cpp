@@ -0,0 +1,141 @@
+#include "GeometryArena.hpp"
+
+#include "Mesh.hpp"
+
+GeometryArena::GeometryArena()
+    : vertexCapacity(ARENA_MIN_VERTICES), indexCapacity(ARENA_MIN_INDICES),
+    noVertices(0), noIndices(0), multiDraw(false), noDrawCalls(0), noCommands(0), generated(false) {}
+
+GeometryRange GeometryArena::add(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    if (!generated) {
+        generate();
+    }
+
+    GeometryRange ret = { noIndices, (unsigned int)indices.size(), (int)noVertices };
+
+    // Element buffer binding is VAO state
+    VAO.bind();
+
+    if (vertexCapacity.fit(noVertices + vertices.size())) {
+        vertexVBO.resize<Vertex>(vertexCapacity.capacity, noVertices, GL_STATIC_DRAW);
+        setVertexAttrPointers();
+    }
+    if (indexCapacity.fit(noIndices + indices.size())) {
+        indexEBO.resize<GLuint>(indexCapacity.capacity, noIndices, GL_STATIC_DRAW);
+    }
+
+    if (vertices.size() > 0) {
+        vertexVBO.bind();
+        vertexVBO.updateData<Vertex>(noVertices * sizeof(Vertex), vertices.size(), &vertices[0]);
+    }
+    if (indices.size() > 0) {
+        indexEBO.bind();
+        indexEBO.updateData<GLuint>(noIndices * sizeof(GLuint), indices.size(), &indices[0]);
+    }
+
+    ArrayObject::clear();
+
+    noVertices += vertices.size();
+    noIndices += indices.size();
+
+    return ret;
+}
+
+void GeometryArena::bind() {
+    VAO.bind();
+}
+
+unsigned int GeometryArena::draw(std::vector<DrawCommand>& commands) {
+    unsigned int noCalls = 0;
+
+    if (commands.empty()) {
+        return noCalls;
+    }
+
+    if (multiDraw) {
+        // Orphan and refill, the list is small and changes every draw
+        commandBuffer.bind();
+        commandBuffer.setData<DrawCommand>(commands.size(), &commands[0], GL_STREAM_DRAW);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, commands.size(), 0);
+        noCalls = 1;
+    }
+    else {
+        for (DrawCommand& command : commands) {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                (void*)(command.firstIndex * sizeof(GLuint)), command.instanceCount, command.baseVertex);
+        }
+        noCalls = commands.size();
+    }
+
+    noDrawCalls += noCalls;
+    noCommands += commands.size();
+    return noCalls;
+}
+
+void GeometryArena::resetStats() {
+    noDrawCalls = 0;
+    noCommands = 0;
+}
+
+void GeometryArena::cleanup() {
+    if (!generated) {
+        return;
+    }
+
+    vertexVBO.cleanup();
+    indexEBO.cleanup();
+    commandBuffer.cleanup();
+    VAO.cleanup();
+
+    vertexCapacity = BufferCapacity(ARENA_MIN_VERTICES);
+    indexCapacity = BufferCapacity(ARENA_MIN_INDICES);
+    noVertices = 0;
+    noIndices = 0;
+    generated = false;
+}
+
+void GeometryArena::generate() {
+#ifndef ARENA_SINGLE_DRAWS
+    multiDraw = GLAD_GL_VERSION_4_3;
+#endif
+
+    VAO.generate();
+    VAO.bind();
+
+    vertexCapacity.fit(0);
+    vertexVBO = BufferObject(GL_ARRAY_BUFFER);
+    vertexVBO.generate();
+    vertexVBO.bind();
+    vertexVBO.setData<Vertex>(vertexCapacity.capacity, (Vertex*)nullptr, GL_STATIC_DRAW);
+    setVertexAttrPointers();
+
+    indexCapacity.fit(0);
+    indexEBO = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
+    indexEBO.generate();
+    indexEBO.bind();
+    indexEBO.setData<GLuint>(indexCapacity.capacity, (GLuint*)nullptr, GL_STATIC_DRAW);
+
+    ArrayObject::clear();
+
+    commandBuffer = BufferObject(GL_DRAW_INDIRECT_BUFFER);
+    commandBuffer.generate();
+
+    generated = true;
+}
+
+void GeometryArena::setVertexAttrPointers() {
+    // VAO bound
+    vertexVBO.bind();
+    // Vertex positions
+    vertexVBO.setAttrPointer<GLfloat>(0, 3, GL_FLOAT, 8, 0);
+    // Normal array
+    vertexVBO.setAttrPointer<GLfloat>(1, 3, GL_FLOAT, 8, 3);
+    // Texture coordinates
+    vertexVBO.setAttrPointer<GLfloat>(2, 2, GL_FLOAT, 8, 6);
+}
+
+GeometryArena& geometryArena() {
+    static GeometryArena arena;
+    return arena;
+}
@@ -0,0 +1,92 @@
+#ifndef GEOMETRY_ARENA_HPP
+#define GEOMETRY_ARENA_HPP
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "glMemory.hpp"
+
+#define ARENA_MIN_VERTICES      65536       // Initial vertex capacity
+#define ARENA_MIN_INDICES       196608      // Initial index capacity
+
+struct Vertex; // Forward declaration
+
+// Part of the arena buffers holding one mesh
+struct GeometryRange {
+    unsigned int firstIndex;
+    unsigned int noIndices;
+    // Added to every index of the mesh (indices stay local to the mesh)
+    int baseVertex;
+};
+
+// Command layout read by glMultiDrawElementsIndirect
+struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/*
+    Vertices and indices of all meshes in shared buffers behind one VAO
+    - meshes get a range, bump allocated and only freed with the arena
+    - buffers grow geometrically, old contents are copied on the GPU
+    - draw() submits a list of commands with one glMultiDrawElementsIndirect on GL 4.3+,
+      or one glDrawElementsInstancedBaseVertex per command (older contexts or ARENA_SINGLE_DRAWS defined)
+    - instance attributes (locations 3+) belong to the model being drawn, set them on VAO before drawing
+*/
+class GeometryArena {
+public:
+    ArrayObject VAO;
+
+    BufferObject vertexVBO;
+    BufferObject indexEBO;
+    // Commands of the last draw (GL_DRAW_INDIRECT_BUFFER)
+    BufferObject commandBuffer;
+
+    BufferCapacity vertexCapacity;
+    BufferCapacity indexCapacity;
+
+    unsigned int noVertices;
+    unsigned int noIndices;
+
+    // glMultiDrawElementsIndirect or per-command draws
+    bool multiDraw;
+
+    // Draw calls issued since resetStats
+    unsigned int noDrawCalls;
+    unsigned int noCommands;
+
+    GeometryArena();
+
+    // Copy mesh into the arena (context has to be current)
+    GeometryRange add(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Bind shared VAO
+    void bind();
+
+    // Draw commands (VAO bound), returns the number of draw calls
+    unsigned int draw(std::vector<DrawCommand>& commands);
+
+    void resetStats();
+
+    // Release buffers and ranges
+    void cleanup();
+
+private:
+    bool generated;
+
+    // Create buffers and VAO on first use
+    void generate();
+
+    // Point vertex attributes at vertexVBO (after it got a new name)
+    void setVertexAttrPointers();
+};
+
+// Arena shared by all meshes
+GeometryArena& geometryArena();
+
+#endif //GEOMETRY_ARENA_HPP
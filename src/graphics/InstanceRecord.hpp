@@ -0,0 +1,31 @@
+#ifndef INSTANCE_RECORD_HPP
+#define INSTANCE_RECORD_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/*
+    Per-instance vertex data, interleaved in one 32 byte record
+    - location 3: position (3 floats)
+    - location 4: size (3 half floats, 4th unused)
+    - location 5: rotation quaternion (x, y, z, w as normalized shorts)
+    - location 6: material/color index (unsigned int)
+*/
+struct InstanceRecord {
+    glm::vec3 pos;
+    unsigned int material;
+    unsigned long long rotation;
+    unsigned long long size;
+
+    InstanceRecord() {}
+
+    InstanceRecord(glm::vec3 pos, glm::quat rotation, glm::vec3 size, unsigned int material)
+        : pos(pos), material(material),
+        rotation(glm::packSnorm4x16(glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w))),
+        size(glm::packHalf4x16(glm::vec4(size, 0.0f))) {}
+};
+
+static_assert(sizeof(InstanceRecord) == 32, "InstanceRecord has to stay 32 bytes");
+
+#endif //INSTANCE_RECORD_HPP
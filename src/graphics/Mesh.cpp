@@ -44,38 +44,11 @@ Mesh::Mesh(BoundingRegion br, aiColor4D diff, aiColor4D spec)
 void Mesh::loadData(std::vector<Vertex> _vertices, std::vector<unsigned int> _indices) {
     this->vertices = _vertices;
     this->indices = _indices;
- 
-    // bind VAO
-    VAO.generate();
-    VAO.bind();
- 
-    // generate/set EBO
-    VAO["EBO"] = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
-    VAO["EBO"].generate();
-    VAO["EBO"].bind();
-    VAO["EBO"].setData<GLuint>(this->indices.size(), &this->indices[0], GL_STATIC_DRAW);
- 
-    // load data into vertex buffers
-    VAO["VBO"] = BufferObject(GL_ARRAY_BUFFER);
-    VAO["VBO"].generate();
-    VAO["VBO"].bind();
-    VAO["VBO"].setData<Vertex>(this->vertices.size(), &this->vertices[0], GL_STATIC_DRAW);
- 
-    // set the vertex attribute pointers
-    VAO["VBO"].bind();
-    // vertex Positions
-    VAO["VBO"].setAttrPointer<GLfloat>(0, 3, GL_FLOAT, 8, 0);
-    // normal ray
-    VAO["VBO"].setAttrPointer<GLfloat>(1, 3, GL_FLOAT, 8, 3);
-    // vertex texture coords
-    VAO["VBO"].setAttrPointer<GLfloat>(2, 3, GL_FLOAT, 8, 6);
- 
-    VAO["VBO"].clear();
- 
-    ArrayObject::clear();
+
+    range = geometryArena().add(this->vertices, this->indices);
 }
 
-void Mesh::render(Shader shader, unsigned int noInstances){
+void Mesh::setMaterial(Shader shader){
     if (noTex) {
         // Materials
         shader.set4Float("material.diffuse", diffuse);
@@ -107,48 +80,37 @@ void Mesh::render(Shader shader, unsigned int noInstances){
             // Bind texture
             textures[i].bind();
         }
+
+        glActiveTexture(GL_TEXTURE0);
     }
+}
 
-    VAO.bind();
-    VAO.draw(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, noInstances);
-    ArrayObject::clear();
+bool Mesh::sameMaterial(Mesh& other){
+    if (noTex != other.noTex) {
+        return false;
+    }
+
+    if (noTex) {
+        return diffuse == other.diffuse && specular == other.specular;
+    }
 
-    glActiveTexture(GL_TEXTURE0);
+    if (textures.size() != other.textures.size()) {
+        return false;
+    }
+    for (unsigned int i = 0; i < textures.size(); ++i) {
+        if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void Mesh::setup(){
-    // Bind VAO
-    VAO.generate();
-    VAO.bind();
-
-    // Generate/set EBO
-    VAO["EBO"] = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
-    VAO["EBO"].generate();
-    VAO["EBO"].bind();
-    VAO["EBO"].setData<GLuint>(indices.size(), &indices[0], GL_STATIC_DRAW);
-
-    // Generate/set VBO
-    VAO["VBO"] = BufferObject(GL_ARRAY_BUFFER);
-    VAO["VBO"].generate();
-    VAO["VBO"].bind();
-    VAO["VBO"].setData<Vertex>(vertices.size(), &vertices[0], GL_STATIC_DRAW);
-
-    // Set vertex attrib pointers
-    // Vertex positions
-    VAO["VBO"].setAttrPointer<GLfloat>(0, 3, GL_FLOAT, 8, 0);
-    // Normal array
-    VAO["VBO"].setAttrPointer<GLfloat>(1, 3, GL_FLOAT, 8, 3);
-    // Texture coordinates
-    VAO["VBO"].setAttrPointer<GLfloat>(2, 2, GL_FLOAT, 8, 6);
-
-    VAO["VBO"].clear();
-
-    ArrayObject::clear();
+DrawCommand Mesh::drawCommand(unsigned int noInstances, unsigned int baseInstance){
+    return { range.noIndices, noInstances, range.firstIndex, range.baseVertex, baseInstance };
 }
 
 void Mesh::cleanup(){
-    // glDeleteVertexArrays(1, &VAO);
-    // glDeleteBuffers(1, &VBO);
-    // glDeleteBuffers(1, &EBO);
-    VAO.cleanup();
-}
\ No newline at end of file
+    // Geometry is released with geometryArena()
+    vertices.clear();
+    indices.clear();
+}
@@ -7,6 +7,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "GeometryArena.hpp"
 #include "Shader.hpp"
 #include "Texture.hpp"
 #include "glMemory.hpp"
@@ -29,7 +30,8 @@ public:
 
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    ArrayObject VAO;
+    // Vertices and indices in geometryArena()
+    GeometryRange range;
 
     std::vector<Texture> textures;
     aiColor4D diffuse;
@@ -44,19 +46,23 @@ public:
     // initialize as material object
     Mesh(BoundingRegion br, aiColor4D diff, aiColor4D spec);
  
-    // load vertex and index data
+    // load vertex and index data (copied into geometryArena())
     void loadData(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
 
-    void render(Shader shader, unsigned int noInstances);
+    // Set material uniforms and bind textures
+    void setMaterial(Shader shader);
+
+    // Determine if meshes can be drawn with the same material state
+    bool sameMaterial(Mesh& other);
+
+    // Command drawing the mesh range noInstances times (submitted by Model::render with its instance attributes)
+    // starting at instance record baseInstance
+    DrawCommand drawCommand(unsigned int noInstances, unsigned int baseInstance = 0);
 
     void cleanup();
 
 private:
-    unsigned int VBO, EBO;
-
     bool noTex;
-
-    void setup();
 };
 
 #endif //MESH_H
\ No newline at end of file
@@ -1,134 +1,280 @@
 #include "Model.hpp"
 
+#include <algorithm>
+#include <cstddef>
+
 #include "../physics/Environment.hpp"
 
-Model::Model(std::string id, BoundTypes boundType, unsigned int maxNoInstances, unsigned int flags)
-    : id(id), boundType(boundType), switches(flags), currentNoInstances(0), maxNoInstances(maxNoInstances) {
+Model::Model(std::string name, BoundTypes boundType, unsigned int noInstances, unsigned int flags)
+    : id(interned::registry().intern(name)), name(name), boundType(boundType), switches(flags), currentNoInstances(0),
+    instanceCapacity(noInstances), noUploadedInstances(0), visibleRanges(VISIBLE_MAX_RANGES, VISIBLE_MERGE_GAP) {
     
 }
 
 RigidBody* Model::generateInstance(glm::vec3 size, float mass, glm::vec3 pos){
-    if (currentNoInstances >= maxNoInstances){
-        // All slots filled
-        return nullptr;
+    // Instance buffers grow to fit in the next render
+    ++currentNoInstances;
+    return instances.add(id, size, mass, pos);
+}
+
+void Model::initInstances() {
+    instanceCapacity.fit(currentNoInstances);
+    unsigned int capacity = instanceCapacity.capacity;
+
+    if (streamsInstances()) {
+        // Streamed every frame
+        instanceVBO.generate(GL_ARRAY_BUFFER, capacity * sizeof(InstanceRecord));
+        return;
     }
 
-    instances.push_back(new RigidBody(id, size, mass, pos));
-    return instances[currentNoInstances++];
+    // Generate instance record VBO
+    recordVBO = BufferObject(GL_ARRAY_BUFFER);
+    recordVBO.generate();
+    recordVBO.bind();
+    recordVBO.setData<InstanceRecord>(capacity, (InstanceRecord*)nullptr, instanceUsage());
+
+    // Arrays are uploaded as they are
+    noUploadedInstances = 0;
+    instances.dirty.mark(0, currentNoInstances);
+    uploadDirtyInstances();
 }
 
-void Model::initInstances() {
-    glm::vec3* posData = nullptr;
-    glm::vec3* sizeData = nullptr;
-    GLenum usage = GL_DYNAMIC_DRAW;
+bool Model::streamsInstances() {
+    // Moving every step, uploading everything that is visible is cheaper than tracking
+    return States::isActive(&switches, DYNAMIC);
+}
 
-    std::vector<glm::vec3> positions, sizes;
+GLenum Model::instanceUsage() {
+    return States::isActive(&switches, CONST_INSTANCES) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+}
 
-    if(States::isActive(&switches, CONST_INSTANCES)) {
-        // Set data pointers
-        for (unsigned int i = 0; i < currentNoInstances; ++i){
-            positions.push_back(instances[i]->pos);
-            sizes.push_back(instances[i]->size);
-        }
+void Model::setInstanceAttrPointers(BufferObject& buffer, GLintptr offset) {
+    // Arena VAO bound
+    buffer.bind();
+    // Position
+    buffer.setRecordAttrPointer<InstanceRecord>(3, 3, GL_FLOAT, GL_FALSE, offset + offsetof(InstanceRecord, pos), 1);
+    // Size
+    buffer.setRecordAttrPointer<InstanceRecord>(4, 3, GL_HALF_FLOAT, GL_FALSE, offset + offsetof(InstanceRecord, size), 1);
+    // Rotation
+    buffer.setRecordAttrPointer<InstanceRecord>(5, 4, GL_SHORT, GL_TRUE, offset + offsetof(InstanceRecord, rotation), 1);
+    // Material
+    buffer.setRecordAttrIPointer<InstanceRecord>(6, 1, GL_UNSIGNED_INT, offset + offsetof(InstanceRecord, material), 1);
+}
 
-        if (positions.size() > 0) {
-            posData = &positions[0];
-            sizeData = &sizes[0];
-        }
+void Model::fitInstanceBuffers() {
+    if (!instanceCapacity.fit(currentNoInstances)) {
+        return;
+    }
 
-        usage = GL_STATIC_DRAW;
+    unsigned int capacity = instanceCapacity.capacity;
+
+    if (streamsInstances()) {
+        // Rewritten every frame, nothing to keep
+        instanceVBO.resize(capacity * sizeof(InstanceRecord));
+    }
+    else {
+        // Keep what was uploaded (copied on the GPU)
+        noUploadedInstances = std::min(noUploadedInstances, capacity);
+        recordVBO.resize<InstanceRecord>(capacity, noUploadedInstances, instanceUsage());
     }
+}
 
-    // Generate positions VBO
-    posVBO = BufferObject(GL_ARRAY_BUFFER);
-    posVBO.generate();
-    posVBO.bind();
-    posVBO.setData<glm::vec3>(UPPER_BOUND, posData, GL_DYNAMIC_DRAW);
+InstanceRecord Model::packInstance(unsigned int idx, glm::vec3 pos) {
+    return InstanceRecord(pos, instances.rotation[idx], instances.size[idx], instances.material[idx]);
+}
 
-    // Generate size VBO
-    sizeVBO = BufferObject(GL_ARRAY_BUFFER);
-    sizeVBO.generate();
-    sizeVBO.bind();
-    sizeVBO.setData<glm::vec3>(UPPER_BOUND, sizeData, GL_DYNAMIC_DRAW);
+void Model::uploadDirtyInstances() {
+    DirtyRanges& dirty = instances.dirty;
+    dirty.clamp(currentNoInstances);
 
-    // Set attribute pointers for each mesh
-    for(unsigned int i = 0, size = meshes.size(); i < size; ++i){
-        meshes[i].VAO.bind();
+    // One upload per span, gaps inside a span are re-sent as they are
+    for (DirtyRanges::Span& span : dirty.getSpans()) {
+        unsigned int count = span.end - span.begin;
 
-        // Set vertex attrib pointers
-        // Positions
-        posVBO.bind();
-        posVBO.setAttrPointer<glm::vec3>(3, 3, GL_FLOAT, 1, 0, 1);
-        // Size
-        sizeVBO.bind();
-        sizeVBO.setAttrPointer<glm::vec3>(4, 3, GL_FLOAT, 1, 0, 1);
+        records.resize(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            records[i] = packInstance(span.begin + i, instances.pos[span.begin + i]);
+        }
 
-        ArrayObject::clear();
+        recordVBO.bind();
+        recordVBO.updateData<InstanceRecord>(span.begin * sizeof(InstanceRecord), count, &records[0]);
     }
+
+    dirty.clear();
+    noUploadedInstances = currentNoInstances;
 }
 
 void Model::removeInstance(unsigned int idx) {
-    instances.erase(instances.begin() + idx);
+    // Store swaps the last instance into the hole (order is not kept)
+    instances.remove(instances.bodies[idx]);
     --currentNoInstances;
 }
 
+void Model::removeInstance(RigidBody* instance) {
+    if (instance->store == &instances) {
+        removeInstance(instance->instanceIdx);
+    }
+}
+
 void Model::removeInstance(std::string instanceId){
     int idx = getIdx(instanceId);
     if (idx != -1){
-        instances.erase(instances.begin() + idx);
-        --currentNoInstances;
+        removeInstance((unsigned int)idx);
     }
 }
 
 unsigned int Model::getIdx(std::string id){
     for (int i = 0; i < currentNoInstances; ++i){
-        if(instances[i]->instanceId == id){
+        if(instances.bodies[i]->instanceId == id){
             return i;
         }
     }
     return -1;
 }
 
+void Model::addBounds(BoundingRegion br) {
+    if (boundType == BoundTypes::AABB) {
+        boxBounds.push_back(br.box());
+    }
+    else {
+        sphereBounds.push_back(br.sphere());
+    }
+}
+
+unsigned int Model::noBounds() {
+    return (boundType == BoundTypes::AABB) ? boxBounds.size() : sphereBounds.size();
+}
+
 void Model::init() {}
 
 
-void Model::render(Shader shader, float dt, Scene* scene, bool setModel) {
+void Model::simulate(float dt) {
+    if (States::isActive(&switches, DYNAMIC)) {
+        instances.step(dt);
+
+        // Octree transforms the new bounds in its next update
+        unsigned char* states = instances.states.data();
+        for (unsigned int i = 0; i < currentNoInstances; ++i) {
+            States::activate(&states[i], INSTANCE_MOVED);
+        }
+    }
+}
+
+void Model::render(Shader shader, Scene* scene, bool setModel) {
     if (setModel){
         shader.setMat4("model", glm::mat4(1.0f));
+        shader.setMat3("normalModel", glm::mat3(1.0f));
     }
 
-    if (!States::isActive(&switches, CONST_INSTANCES)) {
-        // Update VBO data
+    bool cull = scene->frustumCulling;
+    unsigned int noVisibleInstances = 0;
+
+    // Grow (or shrink) instance buffers to the instance count
+    fitInstanceBuffers();
 
-        std::vector<glm::vec3> positions, sizes;
+    if (streamsInstances()) {
+        // Write visible instances straight into the mapped region
+        InstanceRecord* mapped = instanceVBO.map<InstanceRecord>();
 
-        bool doUpdate = States::isActive(&switches, DYNAMIC);
+        // Simulated by Scene::simulate, drawn between the last two steps
+        float alpha = scene->interpolation;
 
-        for(int i = 0; i < currentNoInstances; ++i){
-            if (doUpdate){
-                // Update rigid body
-                instances[i]->update(dt);
-                States::activate(&instances[i]->state, INSTANCE_MOVED);
-            } else {
-                States::deactivate(&instances[i]->state, INSTANCE_MOVED);
+        unsigned char* states = instances.states.data();
+        for (unsigned int i = 0; i < currentNoInstances; ++i) {
+            if (States::isActive(&states[i], INSTANCE_DEAD)) {
+                // Waiting for the octree to release it
+                continue;
             }
 
-            positions.push_back(instances[i]->pos);
-            sizes.push_back(instances[i]->size);
+            if (cull && !States::isActive(&states[i], INSTANCE_VISIBLE)) {
+                // Outside of camera, don't upload
+                continue;
+            }
+
+            mapped[noVisibleInstances++] = packInstance(i, instances.interpolatePos(i, alpha));
         }
 
-        posVBO.bind();
-        posVBO.updateData<glm::vec3>(0, currentNoInstances, &positions[0]);
+        instanceVBO.unmap();
+
+        // Everything was rewritten
+        instances.dirty.clear();
+    }
+    else {
+        // Only instances added, removed or moved since the last frame
+        uploadDirtyInstances();
+
+        // Retained VBO can't be compacted, draw the ranges holding visible instances
+        visibleRanges.clear();
+        unsigned char* states = instances.states.data();
+        for (unsigned int i = 0; i < currentNoInstances; ++i) {
+            if (States::isActive(&states[i], INSTANCE_DEAD)) {
+                continue;
+            }
+
+            if (!cull || States::isActive(&states[i], INSTANCE_VISIBLE)) {
+                visibleRanges.mark(i);
+            }
+        }
+        noVisibleInstances = visibleRanges.noElements();
+    }
 
-        sizeVBO.bind();
-        sizeVBO.updateData<glm::vec3>(0, currentNoInstances, &sizes[0]);
+    if (noVisibleInstances == 0) {
+        return;
     }
 
     shader.setFloat("material.shininess", 0.5f);
 
+    // Shared VAO, point the instance attributes at this model's records
+    GeometryArena& arena = geometryArena();
+    arena.bind();
+    if (streamsInstances()) {
+        // Region just written
+        setInstanceAttrPointers(instanceVBO.buffer, instanceVBO.offset());
+        DirtyRanges::Span all = { 0, noVisibleInstances };
+        drawMeshes(shader, &all, 1);
+    }
+    else if (arena.multiDraw) {
+        // Commands start at the first record of their range
+        setInstanceAttrPointers(recordVBO, 0);
+        std::vector<DirtyRanges::Span>& ranges = visibleRanges.getSpans();
+        drawMeshes(shader, ranges.data(), ranges.size());
+    }
+    else {
+        // Single draws ignore baseInstance, point the attributes at each range instead
+        for (DirtyRanges::Span& span : visibleRanges.getSpans()) {
+            setInstanceAttrPointers(recordVBO, span.begin * sizeof(InstanceRecord));
+            DirtyRanges::Span range = { 0, span.end - span.begin };
+            drawMeshes(shader, &range, 1);
+        }
+    }
+
+    ArrayObject::clear();
+
+    if (streamsInstances()) {
+        // Region can be rewritten once the GPU is past these draws
+        instanceVBO.lock();
+    }
+}
+
+void Model::drawMeshes(Shader& shader, DirtyRanges::Span* ranges, unsigned int noRanges) {
+    GeometryArena& arena = geometryArena();
+
+    // One submission per run of meshes sharing a material
+    commands.clear();
     for(unsigned int i = 0, noMeshes = meshes.size(); i < noMeshes; ++i){
-        meshes[i].render(shader, currentNoInstances);
+        if (commands.size() > 0 && !meshes[i].sameMaterial(meshes[i - 1])) {
+            arena.draw(commands);
+            commands.clear();
+        }
+
+        if (commands.empty()) {
+            meshes[i].setMaterial(shader);
+        }
+        for (unsigned int j = 0; j < noRanges; ++j) {
+            commands.push_back(meshes[i].drawCommand(ranges[j].end - ranges[j].begin, ranges[j].begin));
+        }
     }
+    arena.draw(commands);
 }
 
 void Model::cleanup() {
@@ -139,8 +285,15 @@ void Model::cleanup() {
     //     meshes[i].cleanup();
     // }
 
-    posVBO.cleanup();
-    sizeVBO.cleanup();
+    if (streamsInstances()) {
+        instanceVBO.cleanup();
+    }
+    else {
+        recordVBO.cleanup();
+    }
+
+    instances.clear();
+    currentNoInstances = 0;
 }
 
 void Model::loadModel(std::string path) {
@@ -157,13 +310,29 @@ void Model::loadModel(std::string path) {
 }
 
 void Model::processNode(aiNode* node, const aiScene* scene){
+    bool nodeBounds = States::isActive(&switches, NODE_BOUNDS);
+    std::vector<glm::vec3> nodePoints;
+
     // process all meshes
     for(unsigned int i = 0; i < node->mNumMeshes; ++i){
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
         Mesh newMesh = processMesh(mesh, scene);
         meshes.push_back(newMesh);
-        boundingRegions.push_back(newMesh.br);
-}
+
+        if (nodeBounds) {
+            // Bound the meshes of this node together
+            for (Vertex& vertex : newMesh.vertices) {
+                nodePoints.push_back(vertex.pos);
+            }
+        }
+        else {
+            addBounds(newMesh.br);
+        }
+    }
+
+    if (nodeBounds && nodePoints.size() > 0) {
+        addBounds(calculateBounds(nodePoints));
+    }
 
     // process all child nodes
     for(unsigned int i = 0; i < node->mNumChildren; ++i){
@@ -176,9 +345,7 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
-    BoundingRegion br(boundType);
-    glm::vec3 min((float)(~0));        // min point = max float
-    glm::vec3 max(-(float)(~0));       // max point = min float
+    std::vector<glm::vec3> points;
 
     // vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i){
@@ -191,12 +358,7 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
             mesh->mVertices[i].z
         );
 
-        for (int j = 0; j < 3; ++j){
-            // If smaller than min
-            if(vertex.pos[j] < min[j]) min[j] = vertex.pos[j];
-            // If larger than max
-            if(vertex.pos[j] > max[j]) max[j] = vertex.pos[j];
-        }
+        points.push_back(vertex.pos);
 
         // normal vectors
         vertex.normal = glm::vec3(
@@ -218,36 +380,8 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
 
         vertices.push_back(vertex);
     }
-    // process min/ax for BR
-    if (boundType == BoundTypes::AABB){
-        // Assign max and min
-        br.min = min;
-        br.ogMin = min;
-        br.max = max;
-        br.ogMax = max;
-    }
-    else {
-        // Sphere
-        // Calculate max distance from the center
-        br.center = BoundingRegion(min, max).calculateCenter();
-        br.ogCenter = br.center;
-        float maxRadiusSquared = 0.0f;
-
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i){
-            float radiusSquared = 0.0f; // distance for this vertex
-            for(int j = 0; j < 3; ++j){
-                radiusSquared += (vertices[i].pos[j] - br.center[j]) * (vertices[i].pos[j] - br.center[j]);
-            }
-            if (radiusSquared > maxRadiusSquared) {
-                // found new squared radius
-                // a^2 > b^2 --> |a| > |b|
-                maxRadiusSquared = radiusSquared;
-            }
-        }
-
-        br.radius = sqrt(maxRadiusSquared);
-        br.ogRadius = br.radius;
-    }
+    // process bounds
+    BoundingRegion br = calculateBounds(points);
 
     // Those lines below caused me lots of problem, because by pressing L, the 
     // program lauched the sphere, but it didn't rendered on screen
@@ -292,6 +426,19 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     return ret;
 }
 
+BoundingRegion Model::calculateBounds(std::vector<glm::vec3>& points) {
+    if (boundType == BoundTypes::AABB) {
+        return BoundingRegion(Bounds::enclosingBox(points));
+    }
+
+    if (States::isActive(&switches, TIGHT_BOUNDS)) {
+        return BoundingRegion(Bounds::minimalSphere(points));
+    }
+
+    // Center of the box, farthest vertex sets the radius
+    return BoundingRegion(Bounds::boxCenteredSphere(points));
+}
+
 std::vector<Texture> Model::loadTextures(aiMaterial* mat, aiTextureType type){
     std::vector<Texture> textures;
 
@@ -13,6 +13,7 @@
 
 #include <vector>
 
+#include "InstanceRecord.hpp"
 #include "Mesh.hpp"
 
 #include "models/Box.hpp"
@@ -26,30 +27,44 @@
 #define DYNAMIC             (unsigned int)1
 #define CONST_INSTANCES     (unsigned int)2
 #define NO_TEX              (unsigned int)4
+#define TIGHT_BOUNDS        (unsigned int)8     // Near-minimal bounding spheres at import
+#define NODE_BOUNDS         (unsigned int)16    // One bound per aiNode instead of per mesh
+
+// Visible ranges of retained records (one draw command per range and mesh)
+#define VISIBLE_MAX_RANGES  16      // Ranges kept before merging the closest
+#define VISIBLE_MERGE_GAP   8       // Hidden instances drawn anyway to join two ranges
 
 class Scene; // Forward declaration
 
 class Model {
 public:
-    std::string id;
+    // Interned name
+    ModelId id;
+    std::string name;
 
-    // glm::vec3 pos;
-    RigidBody rb;
     glm::vec3 size;
 
     BoundTypes boundType;
 
     std::vector<Mesh> meshes;
-    std::vector<BoundingRegion> boundingRegions;
 
-    std::vector<RigidBody*> instances;
+    // Bounds of each mesh, only the list matching boundType is filled
+    std::vector<AABB> boxBounds;
+    std::vector<BoundingSphere> sphereBounds;
+
+    // Instance data as structure of arrays
+    InstanceStore instances;
 
-    unsigned int maxNoInstances;
     unsigned int currentNoInstances;
 
+    // Growth/shrink policy of the instance buffers (set before initInstances)
+    BufferCapacity instanceCapacity;
+
     unsigned int switches;
 
-    Model(std::string id, BoundTypes boundType, unsigned int maxNoInstances, unsigned int flags = 0);
+    // Registers name with interned::registry()
+    // - noInstances is the smallest instance buffer capacity, the buffers grow past it on demand
+    Model(std::string name, BoundTypes boundType, unsigned int noInstances, unsigned int flags = 0);
 
     // Initialize method
     virtual void init();
@@ -60,16 +75,31 @@ public:
 
     void loadModel(std::string path);
 
-    virtual void render(Shader shader, float dt, Scene *scene, bool setModel = true);
+    // Advance DYNAMIC instances by one fixed step
+    void simulate(float dt);
+
+    // Draw instances (DYNAMIC ones between the last two steps)
+    virtual void render(Shader shader, Scene *scene, bool setModel = true);
 
     void cleanup();
 
+    // O(1), moves the last instance into idx and deletes the RigidBody
+    // (Scene::markForDeletion waits for the octree to release it first)
     void removeInstance(unsigned int idx);
 
+    void removeInstance(RigidBody* instance);
+
+    // Linear search, requires Scene::debugInstanceIds
     void removeInstance(std::string instanceId);
 
     unsigned int getIdx(std::string id);
 
+    // Add mesh bounds (converted to boundType)
+    void addBounds(BoundingRegion br);
+
+    // Number of mesh bounds
+    unsigned int noBounds();
+
 protected:
     bool noTex; // No texture
 
@@ -79,11 +109,49 @@ protected:
 
     void processNode(aiNode* node, const aiScene* scene);
     Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+
+    // Fit bounds of boundType to vertex positions
+    BoundingRegion calculateBounds(std::vector<glm::vec3>& points);
     std::vector<Texture> loadTextures(aiMaterial* mat, aiTextureType type);
 
-    // VBOs for positions and sizes
-    BufferObject posVBO;
-    BufferObject sizeVBO;
+    // Records of all instances (not DYNAMIC), only dirty ranges are uploaded
+    BufferObject recordVBO;
+
+    // Instances in recordVBO
+    unsigned int noUploadedInstances;
+
+    // Ranges of recordVBO drawn this frame (visible instances)
+    DirtyRanges visibleRanges;
+
+    // Records packed for uploadDirtyInstances
+    std::vector<InstanceRecord> records;
+
+    // Records of the visible instances, rewritten every frame (DYNAMIC)
+    StreamBuffer instanceVBO;
+
+    // Draw commands of the meshes, reused every render
+    std::vector<DrawCommand> commands;
+
+    // DYNAMIC models stream, the others keep their instances in recordVBO
+    bool streamsInstances();
+
+    // Buffer usage hint of recordVBO
+    GLenum instanceUsage();
+
+    // Point instance attributes of the arena VAO at the records starting at offset (bytes) in buffer
+    void setInstanceAttrPointers(BufferObject& buffer, GLintptr offset);
+
+    // Record of instance idx drawn at pos
+    InstanceRecord packInstance(unsigned int idx, glm::vec3 pos);
+
+    // Resize instance buffers if instanceCapacity changes for currentNoInstances
+    void fitInstanceBuffers();
+
+    // Upload instances.dirty to recordVBO
+    void uploadDirtyInstances();
+
+    // Draw the meshes for each range of instance records (ranges start at baseInstance)
+    void drawMeshes(Shader& shader, DirtyRanges::Span* ranges, unsigned int noRanges);
 };
 
 #endif //MODEL_H
\ No newline at end of file
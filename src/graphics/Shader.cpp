@@ -106,6 +106,10 @@ void Shader::set4Float(const std::string& name, glm::vec4 v){
     glUniform4f(glGetUniformLocation(id, name.c_str()), v.x, v.y, v.z, v.w);
 }
 
+void Shader::setMat3(const std::string& name, glm::mat3 val){
+    glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(val));
+}
+
 void Shader::setMat4(const std::string& name, glm::mat4 val){
     glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(val));
 }
\ No newline at end of file
@@ -6,6 +6,75 @@
 
 #include <map>
 
+#define BUFFER_MIN_CAPACITY     64          // Default capacity floor (elements)
+#define BUFFER_GROWTH           2.0f        // Default factor to grow full buffers by
+#define BUFFER_SHRINK_RATIO     0.25f       // Default use below which a buffer counts as oversized...
+#define BUFFER_SHRINK_FRAMES    300         // ...and frames it has to stay oversized before shrinking
+
+#define STREAM_BUFFER_REGIONS   3           // Regions in the ring (frames the GPU may lag behind)
+#define STREAM_BUFFER_TIMEOUT   1000000     // Fence wait per try (ns)
+
+/*
+    Capacity policy of growable buffers (in elements)
+    - grows geometrically as soon as more elements are needed
+    - shrinks by the growth factor after staying oversized for shrinkFrames fits in a row
+    - never below minCapacity
+*/
+struct BufferCapacity {
+    unsigned int minCapacity;
+    float growth;
+    float shrinkRatio;
+    unsigned int shrinkFrames;
+
+    // Current capacity (0 until the first fit)
+    unsigned int capacity;
+    // Fits in a row below shrinkRatio
+    unsigned int noLowFrames;
+
+    BufferCapacity(unsigned int minCapacity = BUFFER_MIN_CAPACITY, float growth = BUFFER_GROWTH,
+        float shrinkRatio = BUFFER_SHRINK_RATIO, unsigned int shrinkFrames = BUFFER_SHRINK_FRAMES)
+        : minCapacity(minCapacity > 0 ? minCapacity : 1), growth(growth), shrinkRatio(shrinkRatio),
+        shrinkFrames(shrinkFrames), capacity(0), noLowFrames(0) {}
+
+    // Update capacity for size elements (call once per frame), returns true if it changed
+    bool fit(unsigned int size) {
+        if (capacity == 0 || size > capacity) {
+            unsigned int newCapacity = capacity > minCapacity ? capacity : minCapacity;
+            while (newCapacity < size) {
+                newCapacity = next(newCapacity);
+            }
+
+            noLowFrames = 0;
+            bool changed = newCapacity != capacity;
+            capacity = newCapacity;
+            return changed;
+        }
+
+        if (capacity > minCapacity && size < capacity * shrinkRatio) {
+            if (++noLowFrames >= shrinkFrames) {
+                noLowFrames = 0;
+
+                unsigned int newCapacity = (unsigned int)(capacity / growth);
+                newCapacity = newCapacity > size ? newCapacity : size;
+                capacity = newCapacity > minCapacity ? newCapacity : minCapacity;
+                return true;
+            }
+        }
+        else {
+            noLowFrames = 0;
+        }
+
+        return false;
+    }
+
+private:
+    // Next capacity up (at least one more element)
+    unsigned int next(unsigned int capacity) {
+        unsigned int ret = (unsigned int)(capacity * growth);
+        return ret > capacity ? ret : capacity + 1;
+    }
+};
+
 /*
     Class for buffer objects
     -VBOs, EBOs, etc
@@ -44,6 +113,25 @@ public:
         glBufferSubData(type, offset, noElements * sizeof(T), data);
     }
 
+    // Reallocate to noElements, keeping the first noKept (copied on the GPU)
+    // - the buffer gets a new name, so attribute pointers have to be set again
+    template<typename T>
+    void resize(GLuint noElements, GLuint noKept, GLenum usage) {
+        GLuint old = val;
+
+        glGenBuffers(1, &val);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, val);
+        glBufferData(GL_COPY_WRITE_BUFFER, noElements * sizeof(T), nullptr, usage);
+
+        if (noKept > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, old);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, noKept * sizeof(T));
+        }
+
+        glDeleteBuffers(1, &old);
+        bind();
+    }
+
     // Set attribute pointers
     template<typename T>
     void setAttrPointer(GLuint idx, GLint size, GLenum type, GLuint stride, GLuint offset, GLuint divisor = 0) {
@@ -55,6 +143,26 @@ public:
         }
     }
 
+    // Set attribute pointer into interleaved records of type T (offset in bytes)
+    template<typename T>
+    void setRecordAttrPointer(GLuint idx, GLint size, GLenum type, GLboolean normalized, GLintptr offset, GLuint divisor = 0) {
+        glVertexAttribPointer(idx, size, type, normalized, sizeof(T), (void*)offset);
+        glEnableVertexAttribArray(idx);
+        if (divisor > 0) {
+            glVertexAttribDivisor(idx, divisor);
+        }
+    }
+
+    // Set integer attribute pointer into interleaved records of type T (int/uint in the shader)
+    template<typename T>
+    void setRecordAttrIPointer(GLuint idx, GLint size, GLenum type, GLintptr offset, GLuint divisor = 0) {
+        glVertexAttribIPointer(idx, size, type, sizeof(T), (void*)offset);
+        glEnableVertexAttribArray(idx);
+        if (divisor > 0) {
+            glVertexAttribDivisor(idx, divisor);
+        }
+    }
+
     // Clear buffer objects (bind 0)
     void clear(){
         glBindBuffer(type, 0);
@@ -66,6 +174,142 @@ public:
     }
 };
 
+/*
+    Class for streaming buffer objects (rewritten every frame)
+    - GL 4.4+: persistently mapped ring of STREAM_BUFFER_REGIONS regions,
+      each region is fenced after its draws and only waited on when the ring wraps
+    - older contexts (or STREAM_BUFFER_ORPHAN defined): orphaned and mapped every frame
+    - write through map(), draw from offset() in the buffer, lock() after the draws
+*/
+class StreamBuffer {
+public:
+    BufferObject buffer;
+    // Bytes per region
+    GLsizeiptr regionSize;
+    // Region being written
+    unsigned int region;
+    unsigned int noRegions;
+    // Persistent mapping or orphaning
+    bool persistent;
+
+    StreamBuffer()
+        : regionSize(0), region(0), noRegions(0), persistent(false), base(nullptr) {
+        for (unsigned int i = 0; i < STREAM_BUFFER_REGIONS; ++i) {
+            fences[i] = nullptr;
+        }
+    }
+
+    // Generate object and allocate storage (context has to be current)
+    void generate(GLenum type, GLsizeiptr regionSize) {
+        this->regionSize = regionSize;
+        region = 0;
+
+        buffer = BufferObject(type);
+        buffer.generate();
+        buffer.bind();
+
+#ifndef STREAM_BUFFER_ORPHAN
+        persistent = GLAD_GL_VERSION_4_4;
+#endif
+
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            noRegions = STREAM_BUFFER_REGIONS;
+            glBufferStorage(type, noRegions * regionSize, nullptr, flags);
+            base = (char*)glMapBufferRange(type, 0, noRegions * regionSize, flags);
+        }
+        else {
+            noRegions = 1;
+            glBufferData(type, regionSize, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    // Reallocate with new region size (contents are rewritten every frame, nothing is kept)
+    // - the buffer gets a new name, so attribute pointers have to be set again
+    void resize(GLsizeiptr regionSize) {
+        GLenum type = buffer.type;
+        cleanup();
+        generate(type, regionSize);
+    }
+
+    // Start writing the next region (write only, don't read back)
+    template<typename T>
+    T* map() {
+        if (persistent) {
+            region = (region + 1) % noRegions;
+            wait(region);
+            return (T*)(base + region * regionSize);
+        }
+
+        // Orphan, the driver hands out new storage while the GPU reads the old one
+        buffer.bind();
+        glBufferData(buffer.type, regionSize, nullptr, GL_STREAM_DRAW);
+        return (T*)glMapBufferRange(buffer.type, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    // Finish writing (coherent mapping needs no flush)
+    void unmap() {
+        if (!persistent) {
+            buffer.bind();
+            glUnmapBuffer(buffer.type);
+        }
+    }
+
+    // Byte offset of the region being written
+    GLintptr offset() {
+        return persistent ? region * regionSize : 0;
+    }
+
+    // Fence the region after the draws reading it
+    void lock() {
+        if (persistent) {
+            if (fences[region]) {
+                glDeleteSync(fences[region]);
+            }
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+
+    // Cleanup
+    void cleanup() {
+        for (unsigned int i = 0; i < STREAM_BUFFER_REGIONS; ++i) {
+            if (fences[i]) {
+                glDeleteSync(fences[i]);
+                fences[i] = nullptr;
+            }
+        }
+
+        if (persistent) {
+            buffer.bind();
+            glUnmapBuffer(buffer.type);
+            base = nullptr;
+        }
+
+        buffer.cleanup();
+    }
+
+private:
+    // Start of the persistent mapping
+    char* base;
+    GLsync fences[STREAM_BUFFER_REGIONS];
+
+    // Block until the GPU is done with region
+    void wait(unsigned int region) {
+        if (!fences[region]) {
+            return;
+        }
+
+        GLenum result;
+        do {
+            result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fences[region]);
+        fences[region] = nullptr;
+    }
+};
+
 /*
     Structure class for array objects
     - VAO
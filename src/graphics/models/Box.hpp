@@ -12,13 +12,14 @@
 #include "../../algorithms/Bounds.hpp"
 #include "../Shader.hpp"
 
-#define UPPER_BOUND 100
-
 class Box{
 public:
     std::vector<glm::vec3> positions;
     std::vector<glm::vec3> sizes;
 
+    // Instance buffer capacity (grows with the number of boxes)
+    BufferCapacity capacity;
+
     void init(){
         vertices = {
             // position                x   y   z   i
@@ -68,17 +69,19 @@ public:
         VAO["VBO"].setData<GLfloat>(vertices.size(), &vertices[0], GL_STATIC_DRAW);
         
         
+        capacity.fit(positions.size());
+
         // Position VBO - dynamic
         VAO["posVBO"] = BufferObject(GL_ARRAY_BUFFER);
         VAO["posVBO"].generate();
         VAO["posVBO"].bind();
-        VAO["posVBO"].setData<glm::vec3>(UPPER_BOUND, NULL, GL_DYNAMIC_DRAW);
+        VAO["posVBO"].setData<glm::vec3>(capacity.capacity, NULL, GL_DYNAMIC_DRAW);
 
         // Size VBO - dynamic
         VAO["sizeVBO"] = BufferObject(GL_ARRAY_BUFFER);
         VAO["sizeVBO"].generate();
         VAO["sizeVBO"].bind();
-        VAO["sizeVBO"].setData<glm::vec3>(UPPER_BOUND, NULL, GL_DYNAMIC_DRAW);
+        VAO["sizeVBO"].setData<glm::vec3>(capacity.capacity, NULL, GL_DYNAMIC_DRAW);
 
         // Set attribute pointers
         VAO["VBO"].bind();
@@ -96,9 +99,17 @@ public:
     void render(Shader shader){
         shader.setMat4("model", glm::mat4(1.0f));
 
-        // Update data
-        int instances = std::min(UPPER_BOUND, (int)positions.size()); // If more than 100 instances, only rebder 100
-        
+        int instances = positions.size();
+
+        if (capacity.fit(instances)) {
+            // Reallocate in place (same buffers, attribute pointers stay valid), data is rewritten below
+            VAO["posVBO"].bind();
+            VAO["posVBO"].setData<glm::vec3>(capacity.capacity, NULL, GL_DYNAMIC_DRAW);
+
+            VAO["sizeVBO"].bind();
+            VAO["sizeVBO"].setData<glm::vec3>(capacity.capacity, NULL, GL_DYNAMIC_DRAW);
+        }
+
         // Update data
         if(instances != 0){
             // If instances exist
@@ -11,8 +11,10 @@ public:
 
     Material material;
 
-    Cube(unsigned int maxNoInstances)
-        : Model("cube", BoundTypes::AABB, maxNoInstances, CONST_INSTANCES | NO_TEX) {}
+    static constexpr ModelId ID = interned::hash("cube");
+
+    Cube(unsigned int noInstances, std::string name = "cube")
+        : Model(name, BoundTypes::AABB, noInstances, CONST_INSTANCES | NO_TEX) {}
 
     void init() {
         int noVertices = 36;
@@ -85,7 +87,7 @@ public:
         ret.loadData(Vertex::genList(vertices, noVertices), indices);
 
         meshes.push_back(ret);
-        boundingRegions.push_back(br);
+        addBounds(br);
     }
 
 };
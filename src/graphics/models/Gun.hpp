@@ -6,19 +6,21 @@
 
 class Gun : public Model {
 public:
-    Gun(unsigned int maxNoInstances)
-        : Model("m4a1", BoundTypes::AABB, maxNoInstances, CONST_INSTANCES | NO_TEX) {}
+    static constexpr ModelId ID = interned::hash("m4a1");
+
+    Gun(unsigned int noInstances)
+        : Model("m4a1", BoundTypes::AABB, noInstances, CONST_INSTANCES | NO_TEX) {}
 
     void init() {
         loadModel("../assets/models/m4a1/scene.gltf");
     }
 
-    void render(Shader shader, float dt, Scene *scene, bool setModel = false){
+    void render(Shader shader, Scene *scene, bool setModel = false){
         glm::mat4 model = glm::mat4(1.0f);
 
         // Set position
-        rb.pos = scene->getActiveCamera()->cameraPos + glm::vec3(scene->getActiveCamera()->cameraFront * 0.5f) - glm::vec3(scene->getActiveCamera()->cameraUp * 0.205f);
-        model = glm::translate(model, rb.pos);
+        glm::vec3 pos = scene->getActiveCamera()->cameraPos + glm::vec3(scene->getActiveCamera()->cameraFront * 0.5f) - glm::vec3(scene->getActiveCamera()->cameraUp * 0.205f);
+        model = glm::translate(model, pos);
 
         float theta;
 
@@ -45,7 +47,9 @@ public:
         model = glm::scale(model, size);
 
         shader.setMat4("model", model);
+        // Normal matrix once per draw instead of per vertex
+        shader.setMat3("normalModel", glm::transpose(glm::inverse(glm::mat3(model))));
 
-        Model::render(shader, dt, scene, false);
+        Model::render(shader, scene, false);
     }
 };
\ No newline at end of file
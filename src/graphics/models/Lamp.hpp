@@ -11,18 +11,18 @@ class Lamp : public Cube {
 public:
     glm::vec3 lightColor;
 
+    static constexpr ModelId ID = interned::hash("lamp");
 
-Lamp(unsigned int maxNoInstances, glm::vec3 lightColor = glm::vec3(1.0f))
-    : Cube(maxNoInstances) {
-        id = "lamp";
+Lamp(unsigned int noInstances, glm::vec3 lightColor = glm::vec3(1.0f))
+    : Cube(noInstances, "lamp") {
         this->lightColor = lightColor;
     }
 
-    void render(Shader shader, float dt, Scene* scene, bool setModel = true){
+    void render(Shader shader, Scene* scene, bool setModel = true){
         // set light color
         shader.set3Float("lightColor", lightColor);
 
-        Cube::render(shader, dt, scene, setModel);
+        Cube::render(shader, scene, setModel);
     }
 };
 
@@ -5,8 +5,10 @@
 
 class Sphere : public Model {
 public:
-    Sphere(unsigned int maxNoInstances)
-        : Model("sphere", BoundTypes::SPHERE, maxNoInstances, NO_TEX | DYNAMIC) {
+    static constexpr ModelId ID = interned::hash("sphere");
+
+    Sphere(unsigned int noInstances)
+        : Model("sphere", BoundTypes::SPHERE, noInstances, NO_TEX | DYNAMIC | TIGHT_BOUNDS) {
         
         }
 
@@ -169,32 +169,34 @@ int main(){
 		
         // process input
 		processInput(deltaTime);
-        
+
+        // advance physics in fixed steps
+        scene.simulate(deltaTime);
 		
         // clear render
 		scene.update();
 
         // Remove launch object if too far
         for (int i = 0; i < sphere.currentNoInstances; ++i){
-            if (glm::length(cam.cameraPos - sphere.instances[i]->pos) > 250.0f) {
-                scene.markForDeletion(sphere.instances[i]->instanceId);
+            if (glm::length(cam.cameraPos - sphere.instances.pos[i]) > 250.0f) {
+                scene.markForDeletion(sphere.instances.bodies[i]->handle);
             }
         }
 
         // Render launch objects
         if (sphere.currentNoInstances > 0) {
             scene.renderShader(shader);
-            scene.renderInstances(sphere.id, shader, deltaTime);
+            scene.renderInstances(sphere.id, shader);
         }
 
 
         // Render lamps
         scene.renderShader(lampShader);
-        scene.renderInstances(lamp.id, lampShader, deltaTime);
+        scene.renderInstances(lamp.id, lampShader);
 
         // Render troglodyte
         scene.renderShader(troglodyteShader);
-        scene.renderInstances(troglodyte.id, troglodyteShader, deltaTime);
+        scene.renderInstances(troglodyte.id, troglodyteShader);
         
         // send new frame to window
         scene.clearDeadInstances();
@@ -216,7 +218,7 @@ int main(){
 }
 
 void launchItem(float dt){
-    RigidBody* rb = scene.generateInstance(sphere.id, glm::vec3(1.0f), 1.0f, cam.cameraPos);
+    RigidBody* rb = scene.generateInstance(Sphere::ID, glm::vec3(1.0f), 1.0f, cam.cameraPos);
     if (rb){
         // Instance generated
         rb->transferEnergy(100.0f, cam.cameraFront);
@@ -0,0 +1,112 @@
+#include "InstanceStore.hpp"
+
+#include <algorithm>
+
+#include "Integrator.hpp"
+#include "RigidBody.hpp"
+
+RigidBody* InstanceStore::add(interned::Id modelId, glm::vec3 size, float mass, glm::vec3 pos) {
+    RigidBody* rb = new RigidBody(this, bodies.size(), modelId);
+
+    dirty.mark(bodies.size());
+
+    this->pos.push_back(pos);
+    prevPos.push_back(pos);
+    velocity.push_back(glm::vec3(0.0f));
+    acceleration.push_back(glm::vec3(0.0f));
+    this->size.push_back(size);
+    rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    material.push_back(0);
+    this->mass.push_back(mass);
+    states.push_back(0);
+    bodies.push_back(rb);
+
+    return rb;
+}
+
+void InstanceStore::remove(RigidBody* rb) {
+    unsigned int idx = rb->instanceIdx;
+    unsigned int last = bodies.size() - 1;
+
+    if (idx != last) {
+        // Move last instance into the hole
+        pos[idx] = pos[last];
+        prevPos[idx] = prevPos[last];
+        velocity[idx] = velocity[last];
+        acceleration[idx] = acceleration[last];
+        size[idx] = size[last];
+        rotation[idx] = rotation[last];
+        material[idx] = material[last];
+        mass[idx] = mass[last];
+        states[idx] = states[last];
+        bodies[idx] = bodies[last];
+        bodies[idx]->instanceIdx = idx;
+
+        dirty.mark(idx);
+    }
+
+    pos.pop_back();
+    prevPos.pop_back();
+    velocity.pop_back();
+    acceleration.pop_back();
+    size.pop_back();
+    rotation.pop_back();
+    material.pop_back();
+    mass.pop_back();
+    states.pop_back();
+    bodies.pop_back();
+    dirty.clamp(bodies.size());
+    ++noRemovals;
+
+    delete rb;
+}
+
+void InstanceStore::clear() {
+    for (RigidBody* rb : bodies) {
+        delete rb;
+    }
+
+    pos.clear();
+    prevPos.clear();
+    velocity.clear();
+    acceleration.clear();
+    size.clear();
+    rotation.clear();
+    material.clear();
+    mass.clear();
+    states.clear();
+    bodies.clear();
+    dirty.clear();
+    ++noRemovals;
+}
+
+unsigned int InstanceStore::noInstances() {
+    return bodies.size();
+}
+
+void InstanceStore::markDirty(unsigned int idx) {
+    dirty.mark(idx);
+}
+
+void InstanceStore::update(float dt) {
+    Integrator::integrate(*this, dt);
+    dirty.mark(0, bodies.size());
+}
+
+void InstanceStore::step(float dt) {
+    std::copy(pos.begin(), pos.end(), prevPos.begin());
+    update(dt);
+}
+
+glm::vec3 InstanceStore::interpolatePos(unsigned int idx, float alpha) {
+    return prevPos[idx] + (pos[idx] - prevPos[idx]) * alpha;
+}
+
+size_t InstanceStore::memoryUsage() {
+    return (pos.capacity() + prevPos.capacity() + velocity.capacity() + acceleration.capacity() + size.capacity()) * sizeof(glm::vec3) +
+        rotation.capacity() * sizeof(glm::quat) +
+        material.capacity() * sizeof(unsigned int) +
+        mass.capacity() * sizeof(float) +
+        states.capacity() * sizeof(unsigned char) +
+        bodies.capacity() * (sizeof(RigidBody*) + sizeof(RigidBody));
+}
@@ -0,0 +1,69 @@
+#ifndef INSTANCE_STORE_HPP
+#define INSTANCE_STORE_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "../algorithms/DirtyRanges.hpp"
+#include "../algorithms/InternedId.hpp"
+
+class RigidBody; // Forward declaration
+
+/*
+    Instances of a model as structure of arrays
+    - index i of every array belongs to bodies[i]
+    - RigidBody objects are the stable handles, they keep their address while the arrays are compacted
+    - remove swaps the last instance into the hole (order is not kept)
+*/
+class InstanceStore {
+public:
+    std::vector<glm::vec3> pos;
+    // Positions before the last step (for interpolation)
+    std::vector<glm::vec3> prevPos;
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> acceleration;
+    std::vector<glm::vec3> size;
+    std::vector<glm::quat> rotation;
+    // Material/color index (passed to the shaders)
+    std::vector<unsigned int> material;
+    std::vector<float> mass;
+    std::vector<unsigned char> states;
+
+    std::vector<RigidBody*> bodies;
+
+    // Instances changed since the last upload (add, remove, step, or INSTANCE_MOVED in Scene::update)
+    DirtyRanges dirty;
+
+    // Incremented by remove and clear (instance indices kept elsewhere may be stale)
+    unsigned int noRemovals = 0;
+
+    // Add instance, returns its handle object
+    RigidBody* add(interned::Id modelId, glm::vec3 size, float mass, glm::vec3 pos);
+
+    // Remove instance and delete its handle object
+    void remove(RigidBody* rb);
+
+    // Remove all instances
+    void clear();
+
+    unsigned int noInstances();
+
+    // Mark instance for the next upload
+    void markDirty(unsigned int idx);
+
+    // Integrate all instances with the batched integrator (same result as RigidBody::update)
+    void update(float dt);
+
+    // Keep positions in prevPos, then integrate
+    void step(float dt);
+
+    // Position between the last two steps (alpha in [0, 1])
+    glm::vec3 interpolatePos(unsigned int idx, float alpha);
+
+    size_t memoryUsage();
+};
+
+#endif //INSTANCE_STORE_HPP
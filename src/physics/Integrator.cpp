@@ -0,0 +1,142 @@
+#include "Integrator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../algorithms/BoundsBatch.hpp"
+#include "../algorithms/Parallel.hpp"
+
+#ifdef BOUNDS_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+using BoundsBatch::SimdLevel;
+
+static bool verifyEnabled = false;
+static unsigned long long noMismatches = 0;
+
+/*
+    Kernels (evaluated in the same order as RigidBody::update)
+*/
+
+void Integrator::integrateScalar(float* pos, float* velocity, const float* acceleration,
+    unsigned int begin, unsigned int end, float dt) {
+    float dtSquared = dt * dt;
+
+    for (unsigned int i = begin; i < end; ++i) {
+        pos[i] += velocity[i] * dt + 0.5f * acceleration[i] * dtSquared;
+        velocity[i] += acceleration[i] * dt;
+    }
+}
+
+#ifdef BOUNDS_BATCH_X86
+static unsigned int integrateSSE(float* pos, float* velocity, const float* acceleration,
+    unsigned int begin, unsigned int end, float dt) {
+    __m128 dtV = _mm_set1_ps(dt);
+    __m128 dtSquared = _mm_set1_ps(dt * dt);
+    __m128 half = _mm_set1_ps(0.5f);
+
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 v = _mm_loadu_ps(velocity + i);
+        __m128 a = _mm_loadu_ps(acceleration + i);
+
+        __m128 delta = _mm_add_ps(_mm_mul_ps(v, dtV), _mm_mul_ps(_mm_mul_ps(half, a), dtSquared));
+        _mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(pos + i), delta));
+        _mm_storeu_ps(velocity + i, _mm_add_ps(v, _mm_mul_ps(a, dtV)));
+    }
+    return i;
+}
+
+AVX2_TARGET static unsigned int integrateAVX2(float* pos, float* velocity, const float* acceleration,
+    unsigned int begin, unsigned int end, float dt) {
+    __m256 dtV = _mm256_set1_ps(dt);
+    __m256 dtSquared = _mm256_set1_ps(dt * dt);
+    __m256 half = _mm256_set1_ps(0.5f);
+
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 v = _mm256_loadu_ps(velocity + i);
+        __m256 a = _mm256_loadu_ps(acceleration + i);
+
+        __m256 delta = _mm256_add_ps(_mm256_mul_ps(v, dtV), _mm256_mul_ps(_mm256_mul_ps(half, a), dtSquared));
+        _mm256_storeu_ps(pos + i, _mm256_add_ps(_mm256_loadu_ps(pos + i), delta));
+        _mm256_storeu_ps(velocity + i, _mm256_add_ps(v, _mm256_mul_ps(a, dtV)));
+    }
+    return i;
+}
+#endif
+
+void Integrator::integrate(float* pos, float* velocity, const float* acceleration,
+    unsigned int begin, unsigned int end, float dt) {
+#ifdef BOUNDS_BATCH_X86
+    SimdLevel level = BoundsBatch::getLevel();
+    if (level == SimdLevel::AVX2) {
+        begin = integrateAVX2(pos, velocity, acceleration, begin, end, dt);
+    }
+    else if (level == SimdLevel::SSE) {
+        begin = integrateSSE(pos, velocity, acceleration, begin, end, dt);
+    }
+#endif
+
+    // Remaining lanes
+    integrateScalar(pos, velocity, acceleration, begin, end, dt);
+}
+
+void Integrator::integrate(InstanceStore& instances, float dt, unsigned int noThreads) {
+    unsigned int noInstances = instances.noInstances();
+    if (noInstances == 0) {
+        return;
+    }
+
+    float* pos = &instances.pos[0].x;
+    float* velocity = &instances.velocity[0].x;
+    const float* acceleration = &instances.acceleration[0].x;
+
+    std::vector<float> expectedPos, expectedVelocity;
+    if (verifyEnabled) {
+        // Reference result from the scalar path
+        expectedPos.assign(pos, pos + 3 * noInstances);
+        expectedVelocity.assign(velocity, velocity + 3 * noInstances);
+        integrateScalar(expectedPos.data(), expectedVelocity.data(), acceleration, 0, 3 * noInstances, dt);
+    }
+
+    noThreads = std::min(Parallel::getNoThreads(noThreads), std::max(1u, noInstances / INTEGRATOR_THREAD_MIN));
+    Parallel::forRange(noInstances, noThreads, [&](unsigned int begin, unsigned int end, unsigned int /*t*/) {
+        integrate(pos, velocity, acceleration, 3 * begin, 3 * end, dt);
+    });
+
+    if (verifyEnabled) {
+        // Bitwise comparison (NaNs must match too)
+        for (unsigned int i = 0; i < 3 * noInstances; ++i) {
+            noMismatches += std::memcmp(&pos[i], &expectedPos[i], sizeof(float)) != 0;
+            noMismatches += std::memcmp(&velocity[i], &expectedVelocity[i], sizeof(float)) != 0;
+        }
+    }
+}
+
+/*
+    Verification
+*/
+
+void Integrator::setVerify(bool verify) {
+    verifyEnabled = verify;
+}
+
+bool Integrator::getVerify() {
+    return verifyEnabled;
+}
+
+unsigned long long Integrator::getNoMismatches() {
+    return noMismatches;
+}
+
+void Integrator::resetMismatches() {
+    noMismatches = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef INTEGRATOR_HPP
+#define INTEGRATOR_HPP
+
+#include "InstanceStore.hpp"
+
+/*
+    Batched integrator
+    - same step as RigidBody::update: pos += v * dt + 0.5 * a * dt^2, v += a * dt
+    - vec3 arrays are integrated as flat float arrays (3 floats per instance)
+    - AVX2 (8 lanes) or SSE (4 lanes), level shared with BoundsBatch::getLevel
+    - large stores are split across worker threads
+    - no fused multiply-add, so every level is bit-identical to the scalar path
+      (verify mode checks it on every call)
+*/
+
+#define INTEGRATOR_THREAD_MIN   65536   // instances per worker thread before splitting
+
+namespace Integrator {
+    // Integrate floats [begin, end) of the flattened arrays
+    void integrate(float* pos, float* velocity, const float* acceleration,
+        unsigned int begin, unsigned int end, float dt);
+
+    // Integrate every instance of store (noThreads = 0 picks from the hardware)
+    void integrate(InstanceStore& instances, float dt, unsigned int noThreads = 0);
+
+    // Integrate with the scalar path only
+    void integrateScalar(float* pos, float* velocity, const float* acceleration,
+        unsigned int begin, unsigned int end, float dt);
+
+    /*
+        Verification
+    */
+
+    // Compare every store integration against the scalar path
+    void setVerify(bool verify);
+    bool getVerify();
+
+    // Floats that differed from the scalar path since the last reset
+    unsigned long long getNoMismatches();
+    void resetMismatches();
+}
+
+#endif //INTEGRATOR_HPP
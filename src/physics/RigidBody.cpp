@@ -1,41 +1,37 @@
 #include "RigidBody.hpp"
 
 bool RigidBody::operator==(RigidBody rb){
-    return instanceId == rb.instanceId;
+    return handle == rb.handle;
 }
 
 bool RigidBody::operator==(std::string id){
     return instanceId == id;
 }
 
-RigidBody::RigidBody(){
-    
-}
-
-RigidBody::RigidBody(std::string modelId, glm::vec3 size, float mass, glm::vec3 pos)
-    : modelId(modelId), size(size), mass(mass), pos(pos), velocity(0.0f), acceleration(0.0f), state(0) {}
+RigidBody::RigidBody(InstanceStore* store, unsigned int instanceIdx, ModelId modelId)
+    : store(store), instanceIdx(instanceIdx), modelId(modelId), handle(slotmap::nullHandle), noObjects(0) {}
 
 void RigidBody::update(float dt){
-    pos += velocity * dt + 0.5f * acceleration * (dt * dt);
-    velocity += acceleration * dt;
+    pos() += velocity() * dt + 0.5f * acceleration() * (dt * dt);
+    velocity() += acceleration() * dt;
 }
 
 void RigidBody::applyForce(glm::vec3 force){
-    acceleration += force / mass;
+    acceleration() += force / mass();
 }
 void RigidBody::applyForce(glm::vec3 direction, float magnitude){
     applyForce(direction * magnitude);
 }
 
 void RigidBody::applyAcceleration(glm::vec3 a){
-    acceleration += a;
+    acceleration() += a;
 }
 void RigidBody::applyAcceleration(glm::vec3 direction, float magnitude){
     applyAcceleration(direction * magnitude);
 }
 
 void RigidBody::applyImpulse(glm::vec3 force, float dt){
-    velocity += force / mass * dt;
+    velocity() += force / mass() * dt;
 }
 
 void RigidBody::applyImpulse(glm::vec3 direction, float magnitude, float dt){
@@ -48,7 +44,7 @@ void RigidBody::transferEnergy(float joules, glm::vec3 direction){
     }
 
     // Comes from formula KE = 1/2 * m * v^2
-    glm::vec3 deltaV = direction * (float)sqrt(2 * abs(joules) / mass);
+    glm::vec3 deltaV = direction * (float)sqrt(2 * abs(joules) / mass());
 
-    velocity += joules > 0 ? deltaV : -deltaV;
+    velocity() += joules > 0 ? deltaV : -deltaV;
 }
\ No newline at end of file
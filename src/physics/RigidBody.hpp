@@ -5,30 +5,82 @@
 
 #include <string>
 
+#include "InstanceStore.hpp"
+#include "../algorithms/InternedId.hpp"
+#include "../algorithms/SlotMap.hpp"
+
 #define INSTANCE_DEAD           (unsigned char)0b00000001
 #define INSTANCE_MOVED          (unsigned char)0b00000010
+#define INSTANCE_VISIBLE        (unsigned char)0b00000100
+
+typedef interned::Id ModelId;
+typedef slotmap::Handle InstanceHandle;
 
+/*
+    Handle to an instance in the InstanceStore of its model
+    - the data lives in the store arrays at instanceIdx
+    - created and deleted by the store, the address stays valid until then
+*/
 class RigidBody{
 public:
-    unsigned char state;
+    InstanceStore* store;
+    // Position in the store arrays
+    unsigned int instanceIdx;
 
-    float mass;
+    ModelId modelId;
+    // Only set when Scene::debugInstanceIds is enabled
+    std::string instanceId;
 
-    glm::vec3 pos;
-    glm::vec3 velocity;
-    glm::vec3 acceleration;
+    // Handle in Scene::instances
+    InstanceHandle handle;
 
-    glm::vec3 size;
-
-    std::string modelId;
-    std::string instanceId;
+    // Octree objects of the instance (it can't be deleted before they are released)
+    unsigned int noObjects;
 
     bool operator==(RigidBody rb);
     bool operator==(std::string id);
 
-    RigidBody();
+    RigidBody(InstanceStore* store, unsigned int instanceIdx, ModelId modelId);
+
+    /*
+        instance data
+    */
+
+    unsigned char& state() {
+        return store->states[instanceIdx];
+    }
+
+    float& mass() {
+        return store->mass[instanceIdx];
+    }
+
+    glm::vec3& pos() {
+        return store->pos[instanceIdx];
+    }
+
+    glm::vec3& velocity() {
+        return store->velocity[instanceIdx];
+    }
+
+    glm::vec3& acceleration() {
+        return store->acceleration[instanceIdx];
+    }
+
+    glm::vec3& size() {
+        return store->size[instanceIdx];
+    }
+
+    glm::quat& rotation() {
+        return store->rotation[instanceIdx];
+    }
+
+    unsigned int& material() {
+        return store->material[instanceIdx];
+    }
 
-    RigidBody(std::string modelId, glm::vec3 size = glm::vec3(1.0f), float mass = 1.0f, glm::vec3 pos = glm::vec3(0.0f));
+    /*
+        physics
+    */
 
     void update(float dt);
 
@@ -44,4 +96,4 @@ public:
     void transferEnergy(float joules, glm::vec3 direction);
 };
 
-#endif
\ No newline at end of file
+#endif
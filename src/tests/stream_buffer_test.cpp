@@ -0,0 +1,239 @@
+/*
+    stream_buffer_test
+    - offscreen test of StreamBuffer (surfaceless EGL context, no window)
+    - every frame writes a pattern through map(), then a draw reads the region from offset()
+      (as a texture buffer) into its own row of an integer target, and lock() fences it
+    - rows are only read back after the ring has wrapped several times, so a region
+      rewritten before its fence signaled shows up as a mismatch
+    - built twice: persistent mapping (GL 4.4+) and orphaning (STREAM_BUFFER_ORPHAN defined)
+
+    usage: stream_buffer_test (exits 0 on success, 1 on a mismatch, 77 without a GL 4.4 context)
+    - with Mesa, LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe
+*/
+
+#include <cstdio>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "../graphics/glMemory.hpp"
+
+#define TEST_ELEMENTS       1024        // unsigned ints per region
+#define TEST_WRAPS          4           // times the ring wraps per pass
+#define TEST_SKIPPED        77          // CTest SKIP_RETURN_CODE
+
+/*
+    Context
+*/
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+
+// Create a surfaceless core context and load GL, returns false if unavailable
+static bool initContext() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+
+    EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint noConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &noConfigs) || noConfigs == 0) {
+        return false;
+    }
+
+    // Both builds run on a 4.4 context, the orphaning one just doesn't use it
+    EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 4,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        return false;
+    }
+
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) && GLAD_GL_VERSION_4_4;
+}
+
+static void cleanupContext() {
+    if (display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) {
+            eglDestroyContext(display, context);
+        }
+        eglTerminate(display);
+    }
+}
+
+/*
+    Test
+*/
+
+static unsigned int noFailures = 0;
+
+static void check(bool condition, const char* what, unsigned int elements, unsigned int frame) {
+    if (!condition) {
+        printf("FAIL %s (elements=%u frame=%u)\n", what, elements, frame);
+        ++noFailures;
+    }
+}
+
+// Value written to element i in frame
+static unsigned int pattern(unsigned int frame, unsigned int i) {
+    return frame * 0x9e3779b9u + i;
+}
+
+// Draws reading a region: every fragment of row frame fetches its texel from the region
+static const char* vertexSource =
+    "#version 330 core\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 4.0 - 1.0;\n"
+    "    gl_Position = vec4(corner, 0.0, 1.0);\n"
+    "}\n";
+static const char* fragmentSource =
+    "#version 330 core\n"
+    "uniform usamplerBuffer region;\n"
+    "out uint value;\n"
+    "void main() {\n"
+    "    value = texelFetch(region, int(gl_FragCoord.x)).r;\n"
+    "}\n";
+
+static GLuint compileProgram() {
+    GLuint program = glCreateProgram();
+    const char* sources[] = { vertexSource, fragmentSource };
+    GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+    for (int i = 0; i < 2; ++i) {
+        GLuint shader = glCreateShader(types[i]);
+        glShaderSource(shader, 1, &sources[i], nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        printf("FAIL program: %s\n", log);
+        ++noFailures;
+    }
+    return program;
+}
+
+// Stream noFrames frames of noElements, draw each into a row of the target and compare the rows at the end
+static void runPass(StreamBuffer& stream, unsigned int noElements, GLuint program) {
+    GLsizeiptr regionSize = noElements * sizeof(unsigned int);
+    unsigned int noFrames = TEST_WRAPS * stream.noRegions + 1;
+
+    check(stream.regionSize == regionSize, "region size", noElements, 0);
+#ifdef STREAM_BUFFER_ORPHAN
+    check(!stream.persistent && stream.noRegions == 1, "orphaning path", noElements, 0);
+#else
+    check(stream.persistent && stream.noRegions == STREAM_BUFFER_REGIONS, "persistent path", noElements, 0);
+#endif
+
+    // Target, one row per frame
+    GLuint target, framebuffer, texture, vao;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, noElements, noFrames, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    check(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "framebuffer", noElements, 0);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glUseProgram(program);
+
+    for (unsigned int frame = 0; frame < noFrames; ++frame) {
+        unsigned int* data = stream.map<unsigned int>();
+        check(data != nullptr, "map", noElements, frame);
+        if (!data) {
+            break;
+        }
+        for (unsigned int i = 0; i < noElements; ++i) {
+            data[i] = pattern(frame, i);
+        }
+        stream.unmap();
+
+        // Regions are handed out round robin
+        unsigned int region = stream.persistent ? (frame + 1) % stream.noRegions : 0;
+        check(stream.region == region && stream.offset() == (GLintptr)(region * regionSize), "region", noElements, frame);
+
+        // Draw from the region, fenced like the instance draws
+        glTexBufferRange(GL_TEXTURE_BUFFER, GL_R32UI, stream.buffer.val, stream.offset(), regionSize);
+        glViewport(0, frame, noElements, 1);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        stream.lock();
+    }
+
+    // Read back only now, nothing forced the draws to finish before the ring wrapped
+    std::vector<unsigned int> result(noFrames * noElements);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, noElements, noFrames, GL_RED_INTEGER, GL_UNSIGNED_INT, result.data());
+
+    for (unsigned int frame = 0; frame < noFrames; ++frame) {
+        bool same = true;
+        for (unsigned int i = 0; i < noElements && same; ++i) {
+            same = result[frame * noElements + i] == pattern(frame, i);
+        }
+        check(same, "readback", noElements, frame);
+    }
+    check(glGetError() == GL_NO_ERROR, "gl error", noElements, noFrames);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &target);
+    glDeleteTextures(1, &texture);
+    glDeleteVertexArrays(1, &vao);
+}
+
+int main() {
+    if (!initContext()) {
+        printf("SKIP no surfaceless GL 4.4 context\n");
+        cleanupContext();
+        return TEST_SKIPPED;
+    }
+    printf("%s, %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    GLuint program = compileProgram();
+
+    StreamBuffer stream;
+    stream.generate(GL_ARRAY_BUFFER, TEST_ELEMENTS * sizeof(unsigned int));
+    runPass(stream, TEST_ELEMENTS, program);
+
+    // resize() starts a new ring, fences of the old one must not leak into it
+    stream.resize(2 * TEST_ELEMENTS * sizeof(unsigned int));
+    runPass(stream, 2 * TEST_ELEMENTS, program);
+
+    stream.cleanup();
+    glDeleteProgram(program);
+    cleanupContext();
+
+    printf("%s path: %s\n", stream.persistent ? "persistent" : "orphaning", noFailures == 0 ? "ok" : "FAILED");
+    return noFailures == 0 ? 0 : 1;
+}